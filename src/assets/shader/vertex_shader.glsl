@@ -1,13 +1,15 @@
 #version 330 core
 
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTex;
-layout (location = 2) in float aFaceID;
-layout (location = 3) in float aTextureLayer;
+// gfx::PackedVertex (8 bytes)
+//  x: x[0..4] y[5..12] z[13..17] face[18..20] lower[21] inset[22]
+//  y: u[0..7] v[8..15] layer[16..23]
+layout (location = 0) in uvec2 aPacked;
 
 uniform mat4 uViewProj;
 uniform vec3 uViewPos;
-uniform vec3 uChunkPos;
+// 頂点バッファの 64 頂点ごとの持ち主のチャンク座標 (cx, cz)
+// (gfx::CubeRenderer::GRANULE_SHIFT と合わせる)
+uniform isamplerBuffer uChunkOrigins;
 uniform vec3 uSunDir;
 
 out vec2 vTex;
@@ -15,24 +17,38 @@ out float vDist;
 out float vLight;
 out float vLayer;
 
+const vec3 NORMALS[6] = vec3[6](
+    vec3(0, 0, 1),  // FRONT
+    vec3(0, 0, -1), // BACK
+    vec3(0, 1, 0),  // TOP
+    vec3(0, -1, 0), // BOTTOM
+    vec3(1, 0, 0),  // RIGHT
+    vec3(-1, 0, 0)  // LEFT
+);
+
+const float LOWER = 0.1;        // 水面を下げる量
+const float INSET = 1.0 / 16.0; // サボテンの側面
+const int GRANULE_SHIFT = 6;
+const float CHUNK_SIZE = 16.0;
+
 void main() {
-    vec3 worldPos = aPos + uChunkPos;
+    uint lo = aPacked.x;
+    uint hi = aPacked.y;
+    uint faceID = (lo >> 18u) & 7u;
+    vec3 normal = NORMALS[faceID];
+
+    vec3 pos = vec3(float(lo & 31u), float((lo >> 5u) & 255u), float((lo >> 13u) & 31u));
+    if ((lo & (1u << 21u)) != 0u) pos.y -= LOWER;
+    if ((lo & (1u << 22u)) != 0u) pos -= normal * INSET;
+
+    // gl_VertexID には base vertex が足されているので、頂点バッファ内の位置になる
+    ivec2 chunk = texelFetch(uChunkOrigins, gl_VertexID >> GRANULE_SHIFT).xy;
+    vec3 worldPos = pos + vec3(float(chunk.x) * CHUNK_SIZE, 0.0, float(chunk.y) * CHUNK_SIZE);
     gl_Position = uViewProj * vec4(worldPos, 1.0);
     
-    vTex = aTex;
-    vDist = distance(worldPos, uViewPos);
-    vLayer = aTextureLayer;
-    // vTex = aTex;
+    vTex = vec2(float(hi & 255u), float((hi >> 8u) & 255u));
     vDist = distance(worldPos, uViewPos);
-
-    vec3 normal;
-    if (aFaceID == 0.0)      normal = vec3(0, 0, 1);  // FRONT
-    else if (aFaceID == 1.0) normal = vec3(0, 0, -1); // BACK
-    else if (aFaceID == 2.0) normal = vec3(0, 1, 0);  // TOP
-    else if (aFaceID == 3.0) normal = vec3(0, -1, 0); // BOTTOM
-    else if (aFaceID == 4.0) normal = vec3(1, 0, 0);  // RIGHT
-    else if (aFaceID == 5.0) normal = vec3(-1, 0, 0); // LEFT
-    else                     normal = vec3(0, 1, 0);
+    vLayer = float((hi >> 16u) & 255u);
 
     vLight = max(dot(normal, normalize(uSunDir)), 0.5);
-}
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <cstdint>
 
 namespace ocm {
@@ -16,4 +17,102 @@ namespace ocm {
         COAL_ORE = 10,
         IRON_ORE = 11,
     };
-}
\ No newline at end of file
+
+    // 透過の分類 (面を出すかの判定は分類同士で決まる)
+    enum class BlockClass : uint8_t {
+        AIR,
+        OPAQUE,
+        WATER,
+        CACTUS,
+        LEAVES,
+        COUNT
+    };
+
+    // 描画パス
+    enum class RenderPass : uint8_t {
+        OPAQUE,
+        TRANSLUCENT, // 不透明の後、深度書き込みなしで描く (水)
+    };
+
+    constexpr uint8_t class_bit(BlockClass c) { return static_cast<uint8_t>(1u << static_cast<int>(c)); }
+
+    // 分類ごとに、隣がどの分類なら面を出すか (class_bit の和)
+    //   不透明: 隣が 空気・水・サボテン・葉
+    //   サボテン: 隣がサボテン以外
+    //   葉: 隣が空気・水
+    //   水: 隣が空気
+    constexpr std::array<uint8_t, static_cast<int>(BlockClass::COUNT)> CLASS_FACES_AGAINST = {
+        0, // AIR (面を持たない)
+        static_cast<uint8_t>(class_bit(BlockClass::AIR) | class_bit(BlockClass::WATER) | class_bit(BlockClass::CACTUS) | class_bit(BlockClass::LEAVES)),
+        class_bit(BlockClass::AIR),
+        static_cast<uint8_t>(class_bit(BlockClass::AIR) | class_bit(BlockClass::OPAQUE) | class_bit(BlockClass::WATER) | class_bit(BlockClass::LEAVES)),
+        static_cast<uint8_t>(class_bit(BlockClass::AIR) | class_bit(BlockClass::WATER)),
+    };
+
+    // ブロックごとの性質
+    struct BlockInfo {
+        bool opaque = true;                   // 隣接面を隠す (セクションの省略判定にも使う)
+        BlockClass cls = BlockClass::OPAQUE;
+        uint8_t faces_against = CLASS_FACES_AGAINST[static_cast<int>(BlockClass::OPAQUE)];
+        RenderPass pass = RenderPass::OPAQUE;
+        uint8_t layers[6] = {};               // テクスチャ層 (FaceDirection 順: 前, 後, 上, 下, 右, 左)
+        bool inset = false;                   // 側面を 1/16 内側に寄せる (gfx::VERTEX_INSET)
+        bool lowered = false;                 // 上端を下げる (gfx::VERTEX_LOWER)
+    };
+
+    namespace block_detail {
+        constexpr BlockInfo block(BlockClass cls, uint8_t top, uint8_t bottom, uint8_t side) {
+            BlockInfo info;
+            info.opaque = cls == BlockClass::OPAQUE;
+            info.cls = cls;
+            info.faces_against = CLASS_FACES_AGAINST[static_cast<int>(cls)];
+            info.layers[0] = side; info.layers[1] = side;
+            info.layers[2] = top;  info.layers[3] = bottom;
+            info.layers[4] = side; info.layers[5] = side;
+            return info;
+        }
+        constexpr BlockInfo block(BlockClass cls, uint8_t layer) { return block(cls, layer, layer, layer); }
+
+        constexpr BlockInfo water() {
+            BlockInfo info = block(BlockClass::WATER, 7);
+            info.pass = RenderPass::TRANSLUCENT;
+            info.lowered = true;
+            return info;
+        }
+        constexpr BlockInfo cactus() {
+            BlockInfo info = block(BlockClass::CACTUS, 13, 11, 12);
+            info.inset = true;
+            return info;
+        }
+
+        constexpr std::array<BlockInfo, 256> make_table() {
+            std::array<BlockInfo, 256> table{}; // 未定義の ID は不透明のプレースホルダ (層 0)
+            auto set = [&](BlockID id, const BlockInfo& info) { table[static_cast<uint8_t>(id)] = info; };
+
+            set(BlockID::AIR,         block(BlockClass::AIR, 0));
+            set(BlockID::DIRT,        block(BlockClass::OPAQUE, 1));
+            set(BlockID::GRASS,       block(BlockClass::OPAQUE, 2, 1, 3));
+            set(BlockID::SAND,        block(BlockClass::OPAQUE, 4));
+            set(BlockID::STONE,       block(BlockClass::OPAQUE, 5));
+            set(BlockID::COBBLESTONE, block(BlockClass::OPAQUE, 6));
+            set(BlockID::WATER,       water());
+            set(BlockID::LOG,         block(BlockClass::OPAQUE, 9, 9, 8));
+            set(BlockID::LEAVES,      block(BlockClass::LEAVES, 10));
+            set(BlockID::CACTUS,      cactus());
+            set(BlockID::COAL_ORE,    block(BlockClass::OPAQUE, 14));
+            set(BlockID::IRON_ORE,    block(BlockClass::OPAQUE, 15));
+            return table;
+        }
+    } // namespace block_detail
+
+    // ID をそのまま添字にした性質表 (ブロックを追加するときは make_table に1行足す)
+    inline constexpr std::array<BlockInfo, 256> BLOCK_INFO = block_detail::make_table();
+
+    inline const BlockInfo& block_info(uint8_t id) { return BLOCK_INFO[id]; }
+    inline const BlockInfo& block_info(BlockID id) { return BLOCK_INFO[static_cast<uint8_t>(id)]; }
+
+    // self の面が隣接ブロック neighbor に対して見えるか
+    inline bool is_face_visible(BlockID self, BlockID neighbor) {
+        return (block_info(self).faces_against >> static_cast<int>(block_info(neighbor).cls)) & 1;
+    }
+} // namespace ocm
@@ -0,0 +1,142 @@
+#include "buffer_arena.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace gfx {
+    BufferArena::BufferArena(size_t capacity) {
+        grow(capacity);
+    }
+
+    BufferArena::Handle BufferArena::allocate(size_t size) {
+        if (size == 0) return INVALID;
+
+        for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+            if (it->second < size) continue;
+
+            size_t offset = it->first;
+            size_t rest = it->second - size;
+            m_free.erase(it);
+            if (rest > 0) m_free.emplace(offset + size, rest);
+
+            Handle handle;
+            if (!m_freeHandles.empty()) {
+                handle = m_freeHandles.back();
+                m_freeHandles.pop_back();
+            } else {
+                handle = static_cast<Handle>(m_blocks.size());
+                m_blocks.emplace_back();
+            }
+            m_blocks[handle] = { offset, size, true };
+            m_used += size;
+            return handle;
+        }
+        return INVALID;
+    }
+
+    void BufferArena::free(Handle handle) {
+        if (handle == INVALID || handle >= m_blocks.size() || !m_blocks[handle].live) return;
+        Block& block = m_blocks[handle];
+        insert_free(block.offset, block.size);
+        m_used -= block.size;
+        block = Block();
+        m_freeHandles.push_back(handle);
+    }
+
+    bool BufferArena::resize(Handle handle, size_t size) {
+        Block& block = m_blocks[handle];
+        if (size == 0) return false;
+        if (size <= block.size) {
+            if (size < block.size) insert_free(block.offset + size, block.size - size);
+            m_used -= block.size - size;
+            block.size = size;
+            return true;
+        }
+
+        // 直後の空き区間を使って伸ばす
+        auto next = m_free.find(block.offset + block.size);
+        size_t extra = size - block.size;
+        if (next == m_free.end() || next->second < extra) return false;
+
+        size_t rest = next->second - extra;
+        m_free.erase(next);
+        if (rest > 0) m_free.emplace(block.offset + size, rest);
+        m_used += extra;
+        block.size = size;
+        return true;
+    }
+
+    void BufferArena::grow(size_t newCapacity) {
+        if (newCapacity <= m_capacity) return;
+        insert_free(m_capacity, newCapacity - m_capacity);
+        m_capacity = newCapacity;
+    }
+
+    std::vector<BufferArena::Move> BufferArena::compact(size_t maxMove) {
+        std::vector<Move> moves;
+        if (m_free.empty()) return moves;
+
+        // 生きている区間をオフセット順に並べ、前から詰める
+        std::vector<Handle> order;
+        order.reserve(allocation_count());
+        for (Handle h = 0; h < m_blocks.size(); h++) {
+            if (m_blocks[h].live) order.push_back(h);
+        }
+        std::sort(order.begin(), order.end(),
+            [&](Handle a, Handle b) { return m_blocks[a].offset < m_blocks[b].offset; });
+
+        size_t cursor = 0;
+        size_t moved = 0;
+        for (Handle h : order) {
+            Block& block = m_blocks[h];
+            if (block.offset > cursor) {
+                if (maxMove != 0 && moved + block.size > maxMove && moved > 0) break;
+                moves.push_back({ h, block.offset, cursor, block.size });
+                block.offset = cursor;
+                moved += block.size;
+            }
+            cursor = block.offset + block.size;
+        }
+        if (moves.empty()) return moves;
+
+        // 空き区間を作り直す
+        m_free.clear();
+        size_t end = 0;
+        for (Handle h : order) {
+            const Block& block = m_blocks[h];
+            if (block.offset > end) m_free.emplace(end, block.offset - end);
+            end = std::max(end, block.offset + block.size);
+        }
+        if (end < m_capacity) m_free.emplace(end, m_capacity - end);
+        return moves;
+    }
+
+    size_t BufferArena::largest_free() const {
+        size_t largest = 0;
+        for (auto const& range : m_free) largest = std::max(largest, range.second);
+        return largest;
+    }
+
+    float BufferArena::fragmentation() const {
+        size_t freeTotal = m_capacity - m_used;
+        if (freeTotal == 0) return 0.0f;
+        return 1.0f - static_cast<float>(largest_free()) / static_cast<float>(freeTotal);
+    }
+
+    void BufferArena::insert_free(size_t offset, size_t size) {
+        auto next = m_free.lower_bound(offset);
+        // 後ろの空きと結合
+        if (next != m_free.end() && next->first == offset + size) {
+            size += next->second;
+            next = m_free.erase(next);
+        }
+        // 前の空きと結合
+        if (next != m_free.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                prev->second += size;
+                return;
+            }
+        }
+        m_free.emplace_hint(next, offset, size);
+    }
+} // namespace gfx
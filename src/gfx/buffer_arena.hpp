@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace gfx {
+    // 大きなバッファ1つを区間に切り分けて貸し出すアロケータ (GL には触れない)
+    // 単位は呼び出し側が決める (CubeRenderer では 64 頂点の粒)。
+    // 空き区間はオフセット順に保持し、解放時に前後の空きと結合する。確保は最初に収まる区間から。
+    // 区間は Handle で参照するので、compact で位置が動いても呼び出し側の持つ値は変わらない。
+    class BufferArena {
+        public:
+            using Handle = uint32_t;
+            static constexpr Handle INVALID = UINT32_MAX;
+
+            // compact で移動した区間 (from から to へ size 単位をコピーする)
+            struct Move {
+                Handle handle;
+                size_t from, to, size;
+            };
+
+            explicit BufferArena(size_t capacity = 0);
+
+            // 収まる空きがなければ INVALID (grow してから再度呼ぶ)
+            Handle allocate(size_t size);
+            void free(Handle handle);
+            // その場で大きさを変える (縮小は常に成功、拡大は直後が空いているときだけ)
+            bool resize(Handle handle, size_t size);
+
+            // 末尾に空きを足す (内容のコピーは呼び出し側)
+            void grow(size_t newCapacity);
+
+            // 区間を前へ詰めて穴をなくす。1回で動かす量は maxMove 単位まで (0 で無制限)
+            // 戻り値の順にコピーすれば、まだ読んでいない区間を上書きすることはない
+            std::vector<Move> compact(size_t maxMove = 0);
+
+            size_t offset(Handle handle) const { return m_blocks[handle].offset; }
+            size_t size(Handle handle) const { return m_blocks[handle].size; }
+
+            size_t capacity() const noexcept { return m_capacity; }
+            size_t used() const noexcept { return m_used; }
+            size_t allocation_count() const noexcept { return m_blocks.size() - m_freeHandles.size(); }
+            size_t largest_free() const;
+            // 空きのうち最大の区間に入らない割合 (0: 空きが1つにまとまっている)
+            float fragmentation() const;
+
+        private:
+            struct Block {
+                size_t offset = 0;
+                size_t size = 0;
+                bool live = false;
+            };
+
+            size_t m_capacity = 0;
+            size_t m_used = 0;
+            std::map<size_t, size_t> m_free; // offset -> size
+            std::vector<Block> m_blocks;     // Handle で引く
+            std::vector<Handle> m_freeHandles;
+
+            void insert_free(size_t offset, size_t size);
+    };
+} // namespace gfx
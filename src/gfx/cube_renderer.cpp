@@ -3,6 +3,7 @@
 #include "shader_utils.hpp"
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 #include <vector>
 #include <iostream>
 #include <windows.h>
@@ -41,6 +42,59 @@ namespace gfx {
     CubeRenderer::~CubeRenderer() {
         if (m_program) glDeleteProgram(m_program);
         if (m_textureArray) glDeleteTextures(1, &m_textureArray);
+        if (m_quadIndices16) glDeleteBuffers(1, &m_quadIndices16);
+        if (m_quadIndices32) glDeleteBuffers(1, &m_quadIndices32);
+        if (m_vao16) glDeleteVertexArrays(1, &m_vao16);
+        if (m_vao32) glDeleteVertexArrays(1, &m_vao32);
+        if (m_vertexBuffer) glDeleteBuffers(1, &m_vertexBuffer);
+        if (m_copyBuffer) glDeleteBuffers(1, &m_copyBuffer);
+        if (m_originTexture) glDeleteTextures(1, &m_originTexture);
+        if (m_originBuffer) glDeleteBuffers(1, &m_originBuffer);
+    }
+
+    // 四角形 0 .. quads-1 のインデックスを作る
+    template <typename Index>
+    static std::vector<Index> make_quad_indices(size_t quads) {
+        std::vector<Index> indices(quads * 6);
+        for (size_t q = 0; q < quads; q++) {
+            Index base = static_cast<Index>(q * 4);
+            Index* out = &indices[q * 6];
+            out[0] = base + 0; out[1] = base + 1; out[2] = base + 2;
+            out[3] = base + 2; out[4] = base + 3; out[5] = base + 0;
+        }
+        return indices;
+    }
+
+    GLenum CubeRenderer::ensure_quad_indices(size_t quads) {
+        bool use16 = quads <= MAX_QUADS_16;
+        GLuint& buffer = use16 ? m_quadIndices16 : m_quadIndices32;
+        size_t& capacity = use16 ? m_quadCapacity16 : m_quadCapacity32;
+        GLuint& vao = use16 ? m_vao16 : m_vao32;
+
+        if (vao == 0) {
+            glGenVertexArrays(1, &vao);
+            attach_vertex_buffer(vao);
+        }
+        if (buffer == 0) glGenBuffers(1, &buffer);
+        // この VAO の EBO になる
+        bind_vao(vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+
+        if (quads > capacity) {
+            // 倍々で拡張する (16bit 側は上限で打ち止め)
+            size_t newCapacity = std::max(quads, std::max<size_t>(capacity * 2, 4096));
+            if (use16) newCapacity = std::min(newCapacity, MAX_QUADS_16);
+
+            if (use16) {
+                std::vector<uint16_t> indices = make_quad_indices<uint16_t>(newCapacity);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+            } else {
+                std::vector<uint32_t> indices = make_quad_indices<uint32_t>(newCapacity);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+            }
+            capacity = newCapacity;
+        }
+        return use16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
     }
 
     GLuint CubeRenderer::compile_shader(const char* source, GLenum shader_type) {
@@ -66,11 +120,7 @@ namespace gfx {
         glAttachShader(program, vertex_shader);
         glAttachShader(program, fragment_shader);
 
-        glBindAttribLocation(program, 0, "aPos");
-        glBindAttribLocation(program, 1, "aNormal"); // if needed in future
-        glBindAttribLocation(program, 2, "aTex");
-        glBindAttribLocation(program, 4, "aFaceID");
-        glBindAttribLocation(program, 5, "aBlockID");
+        glBindAttribLocation(program, 0, "aPacked");
 
         glLinkProgram(program);
 
@@ -140,8 +190,9 @@ namespace gfx {
 
             glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
             glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            // 結合した面 (UV が 0..w, 0..h) でテクスチャを繰り返すため REPEAT
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
             glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
         }
 
@@ -155,6 +206,8 @@ namespace gfx {
 
     void CubeRenderer::setup_frame(const float* viewProj4x4, const glm::vec3& camPos) {
         glUseProgram(m_program);
+        m_boundVao = 0;
+        glBindVertexArray(0);
 
         // get uniforms locations
         GLint vpLoc = glGetUniformLocation(m_program, "uViewProj");
@@ -177,6 +230,12 @@ namespace gfx {
         glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray);
         glUniform1i(glGetUniformLocation(m_program, "uTextureArray"), 0);
 
+        // チャンク座標の表 (頂点バッファの粒ごと)
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, m_originTexture);
+        glUniform1i(glGetUniformLocation(m_program, "uChunkOrigins"), 1);
+        glActiveTexture(GL_TEXTURE0);
+
         // High Contrast
         // glEnable(GL_FRAMEBUFFER_SRGB);
         // glDisable(0x809D); // disable multisampling
@@ -196,91 +255,215 @@ namespace gfx {
 
     void CubeRenderer::update_chunk_mesh(ocm::Chunk& chunk, const MeshData& data) {
         // 不透明メッシュ
-        update_buffer(chunk.vao, chunk.vbo, chunk.ebo, data.opaque_vertices, data.opaque_indices);
-        chunk.indexCount = static_cast<int>(data.opaque_indices.size());
+        upload_mesh(chunk.mesh, chunk.index_type, data.opaque_vertices, chunk.cx(), chunk.cz());
+        chunk.indexCount = static_cast<int>(data.opaque_vertices.size() / 4 * 6);
 
         // 透明メッシュ
-        update_buffer(chunk.trans_vao, chunk.trans_vbo, chunk.trans_ebo, data.trans_vertices, data.trans_indices);
-        chunk.trans_indexCount = static_cast<int>(data.trans_indices.size());
+        upload_mesh(chunk.trans_mesh, chunk.trans_index_type, data.trans_vertices, chunk.cx(), chunk.cz());
+        chunk.trans_indexCount = static_cast<int>(data.trans_vertices.size() / 4 * 6);
+
+        // セクションごとの区間
+        chunk.mesh_sections = 0;
+        for (int s = 0; s <= ocm::SECTION_COUNT; s++) {
+            chunk.section_quads[s] = data.opaque_sections.empty() ? 0 : data.opaque_sections[s];
+            chunk.trans_section_quads[s] = data.trans_sections.empty() ? 0 : data.trans_sections[s];
+        }
+        for (int s = 0; s < ocm::SECTION_COUNT; s++) {
+            if (chunk.section_quads[s] != chunk.section_quads[s + 1] || chunk.trans_section_quads[s] != chunk.trans_section_quads[s + 1]) {
+                chunk.mesh_sections |= static_cast<uint8_t>(1u << s);
+            }
+        }
+
+        // インデックスは共有なので頂点分だけ
+        chunk.gpu_bytes = (data.opaque_vertices.size() + data.trans_vertices.size()) * sizeof(PackedVertex);
     }
 
-    void CubeRenderer::update_buffer(
-        uint32_t& vao, uint32_t& vbo, uint32_t& ebo,
-        const std::vector<ChunkVertex>& vertices, 
-        const std::vector<uint32_t>& indices
-    ) {
-        if (vertices.empty()) return;
-        if (vao == 0) {
-            glGenVertexArrays(1, &vao);
-            glGenBuffers(1, &vbo);
-            glGenBuffers(1, &ebo);
+    void CubeRenderer::release_chunk_mesh(ocm::Chunk& chunk) {
+        m_arena.free(chunk.mesh);
+        m_arena.free(chunk.trans_mesh);
+        chunk.mesh = chunk.trans_mesh = BufferArena::INVALID;
+        chunk.indexCount = chunk.trans_indexCount = 0;
+        chunk.section_quads.fill(0);
+        chunk.trans_section_quads.fill(0);
+        chunk.mesh_sections = 0;
+        chunk.gpu_bytes = 0;
+    }
+
+    void CubeRenderer::upload_mesh(BufferArena::Handle& handle, GLenum& index_type, const std::vector<PackedVertex>& vertices, int cx, int cz) {
+        if (vertices.empty()) {
+            m_arena.free(handle);
+            handle = BufferArena::INVALID;
+            return;
+        }
+
+        // 同じ区間に収まる (直後の空きで伸ばせる) なら上書き、だめなら別の区間へ
+        size_t granules = (vertices.size() + GRANULE_VERTICES - 1) >> GRANULE_SHIFT;
+        if (handle == BufferArena::INVALID || !m_arena.resize(handle, granules)) {
+            m_arena.free(handle);
+            handle = m_arena.allocate(granules);
+            if (handle == BufferArena::INVALID) {
+                size_t capacity = m_arena.capacity() == 0 ? ARENA_INITIAL_GRANULES : m_arena.capacity() * 2;
+                while (capacity - m_arena.capacity() < granules) capacity *= 2;
+                grow_arena(capacity);
+                handle = m_arena.allocate(granules);
+            }
         }
 
-        // Bind and upload data
+        size_t first = m_arena.offset(handle);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER,
+            static_cast<GLintptr>((first << GRANULE_SHIFT) * sizeof(PackedVertex)),
+            static_cast<GLsizeiptr>(vertices.size() * sizeof(PackedVertex)), vertices.data());
+
+        for (size_t g = first; g < first + granules; g++) {
+            m_origins[g * 2 + 0] = cx;
+            m_origins[g * 2 + 1] = cz;
+        }
+        upload_origins(first, granules);
+
+        index_type = ensure_quad_indices(vertices.size() / 4);
+    }
+
+    void CubeRenderer::grow_arena(size_t newCapacity) {
+        size_t oldCapacity = m_arena.capacity();
+        if (m_vertexBuffer != 0 && newCapacity <= oldCapacity) return;
+
+        GLuint buffer = 0;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>((newCapacity << GRANULE_SHIFT) * sizeof(PackedVertex)), nullptr, GL_DYNAMIC_DRAW);
+
+        if (m_vertexBuffer != 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, m_vertexBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                static_cast<GLsizeiptr>((oldCapacity << GRANULE_SHIFT) * sizeof(PackedVertex)));
+            glDeleteBuffers(1, &m_vertexBuffer);
+        }
+        m_vertexBuffer = buffer;
+        m_arena.grow(newCapacity);
+
+        if (m_vao16) attach_vertex_buffer(m_vao16);
+        if (m_vao32) attach_vertex_buffer(m_vao32);
+
+        // チャンク座標の表も同じ粒数に広げ、丸ごと送り直す
+        m_origins.resize(newCapacity * 2, 0);
+        if (m_originBuffer == 0) {
+            glGenBuffers(1, &m_originBuffer);
+            glGenTextures(1, &m_originTexture);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, m_originBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(m_origins.size() * sizeof(int32_t)), m_origins.data(), GL_DYNAMIC_DRAW);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, m_originTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32I, m_originBuffer);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void CubeRenderer::upload_origins(size_t first, size_t count) {
+        glBindBuffer(GL_TEXTURE_BUFFER, m_originBuffer);
+        glBufferSubData(GL_TEXTURE_BUFFER,
+            static_cast<GLintptr>(first * 2 * sizeof(int32_t)),
+            static_cast<GLsizeiptr>(count * 2 * sizeof(int32_t)), &m_origins[first * 2]);
+    }
+
+    void CubeRenderer::attach_vertex_buffer(GLuint vao) {
+        bind_vao(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        // aPacked: 2 x uint32 をそのまま整数で渡す (復号は頂点シェーダー)
+        glEnableVertexAttribArray(0);
+        glVertexAttribIPointer(0, 2, GL_UNSIGNED_INT, sizeof(PackedVertex), (void*)0);
+    }
+
+    void CubeRenderer::bind_vao(GLuint vao) {
+        if (vao == m_boundVao) return;
         glBindVertexArray(vao);
-        // transfer vertex data
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(ChunkVertex), vertices.data(), GL_STATIC_DRAW);
-
-        // transfer index data
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
-
-        // set vertex attribute pointers
-        GLsizei stride = sizeof(ChunkVertex);
-
-        // aPos
-        glEnableVertexAttribArray(0); // position
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-        // aTex
-        glEnableVertexAttribArray(1); // uv
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-        // aFaceID
-        glEnableVertexAttribArray(2); // face index
-        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (void*)(5 * sizeof(float)));
-        // aBlockID
-        glEnableVertexAttribArray(3); // block ID
-        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
-        
-        // unbind VAO
-        glBindVertexArray(0);
+        m_boundVao = vao;
     }
 
-    void CubeRenderer::draw_chunk(const ocm::Chunk& chunk) {
-        if (chunk.vao == 0 || chunk.indexCount == 0) return;
+    void CubeRenderer::compact_step() {
+        if (m_vertexBuffer == 0 || m_arena.fragmentation() <= ARENA_COMPACT_THRESHOLD) return;
 
-        glm::vec3 chunkPos(
-            static_cast<float>(chunk.cx() * ocm::CHUNK_SIZE_X),
-            0.0f,
-            static_cast<float>(chunk.cz() * ocm::CHUNK_SIZE_Z)
-        );
+        std::vector<BufferArena::Move> moves = m_arena.compact(ARENA_COMPACT_STEP);
+        if (moves.empty()) return;
 
-        GLint chunkPosLoc = glGetUniformLocation(m_program, "uChunkPos");
-        glUniform3fv(chunkPosLoc, 1, &chunkPos[0]);
+        size_t largest = 0;
+        for (const BufferArena::Move& move : moves) largest = std::max(largest, move.size);
+        size_t bytes = (largest << GRANULE_SHIFT) * sizeof(PackedVertex);
+        if (m_copyBuffer == 0) glGenBuffers(1, &m_copyBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_copyBuffer);
+        if (bytes > m_copyBufferBytes) {
+            glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_COPY);
+            m_copyBufferBytes = bytes;
+        }
 
-        glBindVertexArray(chunk.vao);
-        glDrawElements(GL_TRIANGLES, chunk.indexCount, GL_UNSIGNED_INT, 0);
+        // 移動先は移動元より前なので、compact の返した順に1つずつ一時領域を経由して写す
+        for (const BufferArena::Move& move : moves) {
+            GLsizeiptr size = static_cast<GLsizeiptr>((move.size << GRANULE_SHIFT) * sizeof(PackedVertex));
+            glBindBuffer(GL_COPY_READ_BUFFER, m_vertexBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_copyBuffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                static_cast<GLintptr>((move.from << GRANULE_SHIFT) * sizeof(PackedVertex)), 0, size);
+            glBindBuffer(GL_COPY_READ_BUFFER, m_copyBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                0, static_cast<GLintptr>((move.to << GRANULE_SHIFT) * sizeof(PackedVertex)), size);
+
+            // チャンク座標も一緒に動かす
+            std::memmove(&m_origins[move.to * 2], &m_origins[move.from * 2], move.size * 2 * sizeof(int32_t));
+            upload_origins(move.to, move.size);
+        }
     }
 
-    void CubeRenderer::draw_chunk_transparent(const ocm::Chunk& chunk) {
-        if (chunk.trans_vao == 0 || chunk.trans_indexCount == 0) return;
+    void CubeRenderer::build_draw_lists(const std::vector<ocm::Chunk*>& chunks, const std::vector<uint8_t>& sections,
+                                        bool transparent, const BufferArena& arena, DrawList& list16, DrawList& list32) {
+        list16.clear();
+        list32.clear();
+        for (size_t i = 0; i < chunks.size(); i++) {
+            const ocm::Chunk* chunk = chunks[i];
+            int count = transparent ? chunk->trans_indexCount : chunk->indexCount;
+            if (count == 0) continue;
+            BufferArena::Handle handle = transparent ? chunk->trans_mesh : chunk->mesh;
+            GLenum type = transparent ? chunk->trans_index_type : chunk->index_type;
+            const auto& quads = transparent ? chunk->trans_section_quads : chunk->section_quads;
+
+            DrawList& list = type == GL_UNSIGNED_SHORT ? list16 : list32;
+            GLint base = static_cast<GLint>(arena.offset(handle) << GRANULE_SHIFT);
+
+            // 見えるセクションの区間を、隣り合うものはつないで1コマンドにする
+            // (空のセクションは長さ 0 なので、カリングされていてもつながりを切らない)
+            uint32_t first = 0, last = 0;
+            for (int s = 0; s < ocm::SECTION_COUNT; s++) {
+                if (!(sections[i] & (1u << s)) || quads[s] == quads[s + 1]) continue;
+                if (first != last && last != quads[s]) {
+                    list.add(static_cast<GLsizei>((last - first) * 6), base + static_cast<GLint>(first * 4));
+                    first = last;
+                }
+                if (first == last) first = quads[s];
+                last = quads[s + 1];
+            }
+            if (first != last) list.add(static_cast<GLsizei>((last - first) * 6), base + static_cast<GLint>(first * 4));
+        }
+    }
 
-        glm::vec3 chunkPos(
-            static_cast<float>(chunk.cx() * ocm::CHUNK_SIZE_X),
-            0.0f,
-            static_cast<float>(chunk.cz() * ocm::CHUNK_SIZE_Z)
-        );
+    void CubeRenderer::submit_draws(const DrawList& list, GLenum index_type) {
+        if (list.empty()) return;
+        bind_vao(index_type == GL_UNSIGNED_SHORT ? m_vao16 : m_vao32);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, list.counts.data(), index_type, list.offsets.data(),
+            static_cast<GLsizei>(list.size()), list.base_vertices.data());
+    }
 
-        GLint chunkPosLoc = glGetUniformLocation(m_program, "uChunkPos");
-        glUniform3fv(chunkPosLoc, 1, &chunkPos[0]);
+    void CubeRenderer::draw_chunks(const std::vector<ocm::Chunk*>& chunks, const std::vector<uint8_t>& sections) {
+        build_draw_lists(chunks, sections, false, m_arena, m_drawList16, m_drawList32);
+        submit_draws(m_drawList16, GL_UNSIGNED_SHORT);
+        submit_draws(m_drawList32, GL_UNSIGNED_INT);
+    }
 
-        // 水用の VAO をバインド
-        glBindVertexArray(chunk.trans_vao);
-        // EBO を使用して描画
-        glDrawElements(GL_TRIANGLES, chunk.trans_indexCount, GL_UNSIGNED_INT, 0);
+    void CubeRenderer::draw_chunks_transparent(const std::vector<ocm::Chunk*>& chunks, const std::vector<uint8_t>& sections) {
+        build_draw_lists(chunks, sections, true, m_arena, m_drawList16, m_drawList32);
         // 水を裏面からも見えるように
         glDisable(GL_CULL_FACE);
-
-        // glBindVertexArray(0);
+        submit_draws(m_drawList16, GL_UNSIGNED_SHORT);
+        submit_draws(m_drawList32, GL_UNSIGNED_INT);
     }
 } // namespace gfx
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <cstdint>
 #include "../world/chunk.hpp"
 #include "vertex.hpp"
+#include "buffer_arena.hpp"
+#include "draw_list.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -19,25 +21,81 @@ namespace gfx {
             // フレーム開始時の共通設定
             void setup_frame(const float* viewProj4x4, const glm::vec3& camPos);
 
-            // 特定のチャンクのメッシュ(VBO/VAO)を生成・更新
+            // 特定のチャンクのメッシュを共有頂点バッファへ転送 (収まるなら同じ区間を上書きする)
             void update_chunk_mesh(ocm::Chunk& chunk, const gfx::MeshData& data);
-            // 内部的なバッファ生成・転送ヘルパー
-            void update_buffer(
-                uint32_t& vao, uint32_t& vbo, uint32_t& ebo,
-                const std::vector<ChunkVertex>& vertices, 
-                const std::vector<uint32_t>& indices
-            );
+            // チャンクの区間を返却する (アンロード時に呼ぶ)
+            void release_chunk_mesh(ocm::Chunk& chunk);
+            // 共有頂点バッファの断片化が進んでいれば、区間を少しずつ前へ詰める (毎フレーム呼ぶ)
+            void compact_step();
 
-            // 指定されたチャンクのVAOをバインドして描画
-            void draw_chunk(const ocm::Chunk& chunk);
-            void draw_chunk_transparent(const ocm::Chunk& chunk);
+            // チャンクをまとめて描画 (インデックスの型ごとに glMultiDrawElementsBaseVertex を1回)
+            // チャンクの原点はシェーダーが gl_VertexID から引くので、チャンクごとの uniform 設定はない
+            // sections[i] は chunks[i] のうち描画するセクション (bit s)
+            void draw_chunks(const std::vector<ocm::Chunk*>& chunks, const std::vector<uint8_t>& sections);
+            void draw_chunks_transparent(const std::vector<ocm::Chunk*>& chunks, const std::vector<uint8_t>& sections);
+
+            // 描画コマンドを組み立てる (GL を呼ばない)
+            static void build_draw_lists(const std::vector<ocm::Chunk*>& chunks, const std::vector<uint8_t>& sections,
+                                         bool transparent, const BufferArena& arena, DrawList& list16, DrawList& list32);
+
+            const BufferArena& arena() const noexcept { return m_arena; }
 
             GLuint program() const noexcept { return m_program; };
             GLuint textureArray() const noexcept { return m_textureArray; };
 
+            // 16bit インデックスで表せる四角形の上限 (頂点 65536 個)
+            static constexpr size_t MAX_QUADS_16 = 65536 / 4;
+
+            // 共有頂点バッファは 64 頂点の粒単位で切り分ける (シェーダーの GRANULE_SHIFT と合わせる)
+            // 粒ごとに持ち主のチャンク座標を記録し、シェーダーは gl_VertexID >> GRANULE_SHIFT で引く
+            static constexpr int GRANULE_SHIFT = 6;
+            static constexpr size_t GRANULE_VERTICES = size_t(1) << GRANULE_SHIFT;
+            static constexpr size_t ARENA_INITIAL_GRANULES = (size_t(1) << 18) >> GRANULE_SHIFT; // 2MB
+            static constexpr float ARENA_COMPACT_THRESHOLD = 0.25f;                              // fragmentation() がこれを超えたら詰める
+            static constexpr size_t ARENA_COMPACT_STEP = (size_t(1) << 16) >> GRANULE_SHIFT;     // 1フレームに動かす粒数
+
         private:
             GLuint m_program = 0;
             GLuint m_textureArray = 0;
+
+            // 全チャンクの頂点を置く1本のバッファと、その区間の管理
+            // 足りなくなったら倍の大きさのバッファを作って中身をコピーする
+            BufferArena m_arena;
+            GLuint m_vertexBuffer = 0;
+            GLuint m_copyBuffer = 0; // 詰めるときの一時領域 (移動元と移動先が重なるため)
+            size_t m_copyBufferBytes = 0;
+
+            // 粒ごとのチャンク座標 (cx, cz) と、それを置くテクスチャバッファ (isamplerBuffer, RG32I)
+            std::vector<int32_t> m_origins;
+            GLuint m_originBuffer = 0;
+            GLuint m_originTexture = 0;
+
+            DrawList m_drawList16;
+            DrawList m_drawList32;
+
+            // 全チャンク共有の四角形インデックス (0,1,2,2,3,0 + 4k)
+            // 必要になった時点で確保し、足りなければ同じバッファ名のまま拡張する
+            GLuint m_quadIndices16 = 0;
+            GLuint m_quadIndices32 = 0;
+            size_t m_quadCapacity16 = 0;
+            size_t m_quadCapacity32 = 0;
+            // インデックスの型ごとの VAO (頂点バッファは共通)
+            GLuint m_vao16 = 0;
+            GLuint m_vao32 = 0;
+            GLuint m_boundVao = 0;
+
+            // vertices を区間 handle へ転送する (空なら返却、収まらなければ移動・拡張)
+            void upload_mesh(BufferArena::Handle& handle, GLenum& index_type, const std::vector<PackedVertex>& vertices, int cx, int cz);
+            // 頂点バッファを newCapacity 粒分に拡張する
+            void grow_arena(size_t newCapacity);
+            // 粒 first から count 個のチャンク座標を GPU へ送る
+            void upload_origins(size_t first, size_t count);
+            void submit_draws(const DrawList& list, GLenum index_type);
+            // index_type の VAO に頂点バッファを設定する
+            void attach_vertex_buffer(GLuint vao);
+            void bind_vao(GLuint vao);
+            // quads 枚分のインデックスを用意し、その型を返す
+            GLenum ensure_quad_indices(size_t quads);
             GLuint compile_shader(const char* source, GLenum shader_type);
             GLuint link_program(GLuint vertex_shader, GLuint fragment_shader);
     };
@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+#include <glad/glad.h>
+
+namespace gfx {
+    // glMultiDrawElementsBaseVertex にそのまま渡す描画コマンドの並び
+    // GL を呼ばずに組み立てるので、描画コンテキストがなくても中身を確かめられる
+    struct DrawList {
+        std::vector<GLsizei> counts;        // インデックス数
+        std::vector<GLint> base_vertices;   // 頂点バッファ内の先頭頂点
+        std::vector<const void*> offsets;   // インデックスバッファ内の開始位置 (共有なので常に 0)
+
+        void clear() {
+            counts.clear();
+            base_vertices.clear();
+            offsets.clear();
+        }
+        void add(GLsizei count, GLint baseVertex) {
+            counts.push_back(count);
+            base_vertices.push_back(baseVertex);
+            offsets.push_back(nullptr);
+        }
+        size_t size() const noexcept { return counts.size(); }
+        bool empty() const noexcept { return counts.empty(); }
+    };
+} // namespace gfx
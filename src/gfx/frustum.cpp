@@ -0,0 +1,59 @@
+#include "frustum.hpp"
+#include <cmath>
+
+namespace gfx {
+    Frustum::Frustum(const glm::mat4& viewProj) {
+        // 行列の行 (glm は列優先なので m[列][行])
+        auto row = [&](int r) {
+            return glm::vec4(viewProj[0][r], viewProj[1][r], viewProj[2][r], viewProj[3][r]);
+        };
+        const glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+        // 左, 右, 下, 上, 近, 遠
+        const glm::vec4 planes[6] = { r3 + r0, r3 - r0, r3 + r1, r3 - r1, r3 + r2, r3 - r2 };
+        for (int i = 0; i < 6; i++) {
+            const glm::vec4& p = planes[i];
+            float len = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+            float inv = len > 0.0f ? 1.0f / len : 0.0f;
+            m_a[i] = p.x * inv;
+            m_b[i] = p.y * inv;
+            m_c[i] = p.z * inv;
+            m_d[i] = p.w * inv;
+        }
+    }
+
+    Frustum::Result Frustum::classify(const AABB& box) const {
+        Result result = Result::INSIDE;
+        for (int i = 0; i < 6; i++) {
+            // 法線方向に最も進んだ頂点 (p) と最も遅れた頂点 (n)
+            float px = m_a[i] >= 0.0f ? box.max.x : box.min.x;
+            float py = m_b[i] >= 0.0f ? box.max.y : box.min.y;
+            float pz = m_c[i] >= 0.0f ? box.max.z : box.min.z;
+            if (m_a[i] * px + m_b[i] * py + m_c[i] * pz + m_d[i] < 0.0f) return Result::OUTSIDE;
+
+            float nx = m_a[i] >= 0.0f ? box.min.x : box.max.x;
+            float ny = m_b[i] >= 0.0f ? box.min.y : box.max.y;
+            float nz = m_c[i] >= 0.0f ? box.min.z : box.max.z;
+            if (m_a[i] * nx + m_b[i] * ny + m_c[i] * nz + m_d[i] < 0.0f) result = Result::INTERSECT;
+        }
+        return result;
+    }
+
+    uint32_t Frustum::test_boxes(const AABB* boxes, int count) const {
+        uint32_t visible = count >= 32 ? ~0u : (1u << count) - 1;
+        for (int i = 0; i < 6; i++) {
+            const float a = m_a[i], b = m_b[i], c = m_c[i], d = m_d[i];
+            uint32_t inside = 0;
+            for (int k = 0; k < count; k++) {
+                // p 頂点での符号付き距離 (max(a*min, a*max) は a の符号で選ぶのと同じ)
+                float dist = std::fmax(a * boxes[k].min.x, a * boxes[k].max.x)
+                           + std::fmax(b * boxes[k].min.y, b * boxes[k].max.y)
+                           + std::fmax(c * boxes[k].min.z, c * boxes[k].max.z) + d;
+                inside |= static_cast<uint32_t>(dist >= 0.0f) << k;
+            }
+            visible &= inside;
+            if (visible == 0) break;
+        }
+        return visible;
+    }
+} // namespace gfx
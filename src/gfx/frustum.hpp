@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace gfx {
+    // 軸に平行な箱 (ワールド座標)
+    struct AABB {
+        glm::vec3 min, max;
+    };
+
+    // viewProj 行列から取り出した6枚の平面による視錐台 (GL には触れない)
+    // 平面は法線を内向きに正規化して保持し、ax + by + cz + d >= 0 が内側。
+    class Frustum {
+        public:
+            enum class Result {
+                OUTSIDE,   // 完全に外
+                INTERSECT, // 境界をまたぐ
+                INSIDE,    // 完全に内
+            };
+
+            Frustum() = default;
+            // viewProj = projection * view (クリップ座標 -w <= x, y, z <= w)
+            explicit Frustum(const glm::mat4& viewProj);
+
+            Result classify(const AABB& box) const;
+            bool intersects(const AABB& box) const { return classify(box) != Result::OUTSIDE; }
+
+            // count 個 (32 以下) の箱をまとめて判定し、外にないものを bit i に立てて返す
+            // 平面ごとに全ての箱を回すので、ループがベクトル化しやすい
+            uint32_t test_boxes(const AABB* boxes, int count) const;
+
+        private:
+            // 平面の係数を成分ごとに並べる (a[i] x + b[i] y + c[i] z + d[i])
+            float m_a[6] = {}, m_b[6] = {}, m_c[6] = {}, m_d[6] = {};
+    };
+} // namespace gfx
@@ -0,0 +1,144 @@
+#include "occlusion_buffer.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace gfx {
+    // 箱の頂点番号は (x ? 1 : 0) | (y ? 2 : 0) | (z ? 4 : 0)
+    // 各面は外から見て反時計回り (GL の表面と同じ)
+    static const int BOX_FACES[6][4] = {
+        { 0, 4, 6, 2 }, // -x
+        { 1, 3, 7, 5 }, // +x
+        { 0, 1, 5, 4 }, // -y
+        { 2, 6, 7, 3 }, // +y
+        { 0, 2, 3, 1 }, // -z
+        { 4, 5, 7, 6 }, // +z
+    };
+
+    OcclusionBuffer::OcclusionBuffer(int width, int height)
+        : m_width(width), m_height(height) {
+        int w = width, h = height;
+        while (true) {
+            m_levels.push_back({ w, h, std::vector<float>(static_cast<size_t>(w) * h, 1.0f) });
+            if (w == 1 && h == 1) break;
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+        }
+    }
+
+    void OcclusionBuffer::clear(const glm::mat4& viewProj) {
+        m_viewProj = viewProj;
+        std::fill(m_levels[0].depth.begin(), m_levels[0].depth.end(), 1.0f);
+    }
+
+    bool OcclusionBuffer::project_box(const AABB& box, ScreenVertex out[8]) const {
+        for (int i = 0; i < 8; i++) {
+            glm::vec4 corner((i & 1) ? box.max.x : box.min.x,
+                             (i & 2) ? box.max.y : box.min.y,
+                             (i & 4) ? box.max.z : box.min.z, 1.0f);
+            glm::vec4 clip = m_viewProj * corner;
+            // 近平面で切り取らない代わりに、かかる箱は扱わない
+            if (clip.w <= 0.0f || clip.z < -clip.w) return false;
+            float inv = 1.0f / clip.w;
+            out[i].x = (clip.x * inv * 0.5f + 0.5f) * static_cast<float>(m_width);
+            out[i].y = (clip.y * inv * 0.5f + 0.5f) * static_cast<float>(m_height);
+            out[i].z = clip.z * inv;
+        }
+        return true;
+    }
+
+    void OcclusionBuffer::draw_occluder(const AABB& box) {
+        ScreenVertex v[8];
+        if (!project_box(box, v)) return;
+        for (const auto& face : BOX_FACES) {
+            draw_triangle(v[face[0]], v[face[1]], v[face[2]]);
+            draw_triangle(v[face[0]], v[face[2]], v[face[3]]);
+        }
+    }
+
+    void OcclusionBuffer::draw_triangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2) {
+        // 反時計回りなら正 (裏向き・潰れた三角形は描かない)
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+        if (area <= 0.0f) return;
+
+        int x0 = std::max(0, static_cast<int>(std::floor(std::min({ v0.x, v1.x, v2.x }))));
+        int x1 = std::min(m_width - 1, static_cast<int>(std::floor(std::max({ v0.x, v1.x, v2.x }))));
+        int y0 = std::max(0, static_cast<int>(std::floor(std::min({ v0.y, v1.y, v2.y }))));
+        int y1 = std::min(m_height - 1, static_cast<int>(std::floor(std::max({ v0.y, v1.y, v2.y }))));
+        if (x0 > x1 || y0 > y1) return;
+
+        // 辺 a -> b の関数 (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x) は p.x について一次
+        // w0, w1, w2 はそれぞれ向かいの辺の値 (= 重心座標 * area)
+        const float inv = 1.0f / area;
+        const float dx0 = -(v2.y - v1.y), dx1 = -(v0.y - v2.y), dx2 = -(v1.y - v0.y);
+        const float z0 = v0.z * inv, z1 = v1.z * inv, z2 = v2.z * inv;
+        const int count = x1 - x0 + 1;
+        Level& level = m_levels[0];
+
+        for (int y = y0; y <= y1; y++) {
+            float py = static_cast<float>(y) + 0.5f;
+            float px = static_cast<float>(x0) + 0.5f;
+            float e0 = (v2.x - v1.x) * (py - v1.y) - (v2.y - v1.y) * (px - v1.x);
+            float e1 = (v0.x - v2.x) * (py - v2.y) - (v0.y - v2.y) * (px - v2.x);
+            float e2 = (v1.x - v0.x) * (py - v0.y) - (v1.y - v0.y) * (px - v0.x);
+
+            // 分岐なしの1行 (コンパイラがベクトル化できる形)
+            float* row = &level.depth[static_cast<size_t>(y) * m_width + x0];
+            for (int i = 0; i < count; i++) {
+                float fi = static_cast<float>(i);
+                float w0 = e0 + dx0 * fi;
+                float w1 = e1 + dx1 * fi;
+                float w2 = e2 + dx2 * fi;
+                float z = w0 * z0 + w1 * z1 + w2 * z2;
+                bool inside = (w0 >= 0.0f) & (w1 >= 0.0f) & (w2 >= 0.0f) & (z < row[i]);
+                row[i] = inside ? z : row[i];
+            }
+        }
+    }
+
+    void OcclusionBuffer::build_pyramid() {
+        for (size_t l = 1; l < m_levels.size(); l++) {
+            const Level& src = m_levels[l - 1];
+            Level& dst = m_levels[l];
+            for (int y = 0; y < dst.height; y++) {
+                int sy0 = y * 2, sy1 = std::min(y * 2 + 1, src.height - 1);
+                for (int x = 0; x < dst.width; x++) {
+                    int sx0 = x * 2, sx1 = std::min(x * 2 + 1, src.width - 1);
+                    dst.depth[y * dst.width + x] = std::max(
+                        std::max(src.depth[sy0 * src.width + sx0], src.depth[sy0 * src.width + sx1]),
+                        std::max(src.depth[sy1 * src.width + sx0], src.depth[sy1 * src.width + sx1]));
+                }
+            }
+        }
+    }
+
+    bool OcclusionBuffer::is_occluded(const AABB& box) const {
+        ScreenVertex v[8];
+        if (!project_box(box, v)) return false;
+
+        float minX = v[0].x, maxX = v[0].x, minY = v[0].y, maxY = v[0].y, minZ = v[0].z;
+        for (int i = 1; i < 8; i++) {
+            minX = std::min(minX, v[i].x);
+            maxX = std::max(maxX, v[i].x);
+            minY = std::min(minY, v[i].y);
+            maxY = std::max(maxY, v[i].y);
+            minZ = std::min(minZ, v[i].z);
+        }
+        int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+        int x1 = std::min(m_width - 1, static_cast<int>(std::floor(maxX)));
+        int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+        int y1 = std::min(m_height - 1, static_cast<int>(std::floor(maxY)));
+        if (x0 > x1 || y0 > y1) return false;
+
+        // 範囲が一辺 4 要素以内に収まる段で、範囲内の最も遠い深度と比べる
+        int l = 0;
+        while (l + 1 < level_count() && std::max((x1 >> l) - (x0 >> l), (y1 >> l) - (y0 >> l)) >= 4) l++;
+        const Level& level = m_levels[l];
+        float farthest = -1.0f;
+        for (int y = y0 >> l; y <= (y1 >> l); y++) {
+            for (int x = x0 >> l; x <= (x1 >> l); x++) {
+                farthest = std::max(farthest, level.depth[y * level.width + x]);
+            }
+        }
+        return minZ > farthest;
+    }
+} // namespace gfx
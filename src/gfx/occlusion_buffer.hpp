@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "frustum.hpp"
+
+namespace gfx {
+    // CPU で遮蔽物の箱を描く低解像度の深度バッファ (GL には触れない)
+    // 毎フレーム clear → draw_occluder → build_pyramid の順に呼び、その後 is_occluded で箱を判定する。
+    // 深度は NDC の z (-1 .. 1、clear 値は 1)。ミップの各要素は下の段の 2x2 のうち最も遠い値。
+    class OcclusionBuffer {
+        public:
+            OcclusionBuffer(int width, int height);
+
+            int width() const noexcept { return m_width; }
+            int height() const noexcept { return m_height; }
+
+            void clear(const glm::mat4& viewProj);
+            // 箱の表向きの面を描く (近平面より手前にかかる箱は描かない)
+            void draw_occluder(const AABB& box);
+            void build_pyramid();
+
+            // 箱の投影範囲の全てが描いた遮蔽物より奥にあれば true (判定できなければ false)
+            bool is_occluded(const AABB& box) const;
+
+            // 深度 (段 level の (x, y)、y は下から)
+            float depth(int level, int x, int y) const { return m_levels[level].depth[y * m_levels[level].width + x]; }
+            int level_count() const noexcept { return static_cast<int>(m_levels.size()); }
+
+        private:
+            struct Level {
+                int width, height;
+                std::vector<float> depth;
+            };
+            // 画面上の頂点 (x, y はピクセル単位、z は NDC)
+            struct ScreenVertex {
+                float x, y, z;
+            };
+
+            int m_width, m_height;
+            glm::mat4 m_viewProj{1.0f};
+            std::vector<Level> m_levels; // [0] が最も細かい
+
+            // 箱の8頂点を画面へ (いずれかが近平面より手前なら false)
+            bool project_box(const AABB& box, ScreenVertex out[8]) const;
+            void draw_triangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2);
+    };
+} // namespace gfx
@@ -1,18 +1,87 @@
 #pragma once
+#include <cstdint>
+#include <vector>
+
 namespace gfx {
-    struct ChunkVertex { 
+    // 展開後の頂点 (パックする前の float 表現。シェーダー側の復号結果と同じ値になる)
+    struct ChunkVertex {
         float x, y, z;
         float u, v;
         float faceID;
         float blockID;
     };
 
+    // GPU に送る 8 バイトの頂点 (vertex_shader.glsl で復号する)
+    //  lo: x[0..4] y[5..12] z[13..17] face[18..20] lower[21] inset[22]
+    //  hi: u[0..7] v[8..15] layer[16..23]
+    // 座標はチャンク内の格子点 (x, z: 0..16, y: 0..128)、u, v は結合した面の大きさまで
+    struct PackedVertex {
+        uint32_t lo, hi;
+    };
+    static_assert(sizeof(PackedVertex) == 8, "PackedVertex must be 8 bytes");
+
+    // lower: 水面を下げる量 (上端の頂点だけ y -= VERTEX_LOWER)
+    // inset: サボテンの側面を面の法線と逆向きに寄せる量
+    constexpr float VERTEX_LOWER = 0.1f;
+    constexpr float VERTEX_INSET = 1.0f / 16.0f;
+
+    inline PackedVertex pack_vertex(int x, int y, int z, int u, int v, int face, int layer, bool lower, bool inset) {
+        PackedVertex p;
+        p.lo = static_cast<uint32_t>(x)
+             | static_cast<uint32_t>(y) << 5
+             | static_cast<uint32_t>(z) << 13
+             | static_cast<uint32_t>(face) << 18
+             | static_cast<uint32_t>(lower) << 21
+             | static_cast<uint32_t>(inset) << 22;
+        p.hi = static_cast<uint32_t>(u)
+             | static_cast<uint32_t>(v) << 8
+             | static_cast<uint32_t>(layer) << 16;
+        return p;
+    }
+
+    // シェーダーと同じ手順で float に戻す (デバッグ・検証用)
+    inline ChunkVertex unpack_vertex(const PackedVertex& p) {
+        int face = (p.lo >> 18) & 7;
+        ChunkVertex v;
+        v.x = static_cast<float>(p.lo & 31);
+        v.y = static_cast<float>((p.lo >> 5) & 255);
+        v.z = static_cast<float>((p.lo >> 13) & 31);
+        v.u = static_cast<float>(p.hi & 255);
+        v.v = static_cast<float>((p.hi >> 8) & 255);
+        v.faceID = static_cast<float>(face);
+        v.blockID = static_cast<float>((p.hi >> 16) & 255);
+
+        if (p.lo & (1u << 21)) v.y -= VERTEX_LOWER;
+        if (p.lo & (1u << 22)) {
+            // FRONT(0): z+ / BACK(1): z- / RIGHT(4): x+ / LEFT(5): x-
+            switch (face) {
+                case 0: v.z -= VERTEX_INSET; break;
+                case 1: v.z += VERTEX_INSET; break;
+                case 4: v.x -= VERTEX_INSET; break;
+                case 5: v.x += VERTEX_INSET; break;
+                default: break;
+            }
+        }
+        return v;
+    }
+
     struct MeshData {
         int cx, cz;
-        std::vector<ChunkVertex> opaque_vertices;
-        std::vector<uint32_t> opaque_indices;
+        uint32_t version = 0; // 元にしたチャンクの版 (Chunk::version)
+        // 4 頂点ずつの四角形 (インデックスは CubeRenderer の共有バッファ)
+        std::vector<PackedVertex> opaque_vertices;
         // for transparent blocks (e.g. water)
-        std::vector<ChunkVertex> trans_vertices;
-        std::vector<uint32_t> trans_indices;
+        std::vector<PackedVertex> trans_vertices;
+        // 四角形はセクション (y 方向 16 段) の順に並べる
+        // セクション s の四角形は [sections[s], sections[s + 1]) (四角形単位、要素数はセクション数 + 1)
+        std::vector<uint32_t> opaque_sections;
+        std::vector<uint32_t> trans_sections;
+        // セクションごとの面のつながり (ocm::FaceConnectivity、要素数はセクション数)
+        std::vector<uint64_t> section_connectivity;
+        // 下から途切れずに不透明な高さ (ocm::compute_solid_heights、区画ごと)
+        std::vector<uint8_t> solid_heights;
+
+        // 結合前の可視面の数 (出力した四角形数との比較用)
+        uint32_t face_count = 0;
     };
-} // namespace gfx
\ No newline at end of file
+} // namespace gfx
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <cstdlib>
+#include <cinttypes>
 #include <chrono>
+#include <memory>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -46,12 +48,6 @@ int main(int argc, char** argv) {
 
     World world;
     world.init(seed);
-    std::printf("[main] Generating 4x4 world chunks...\n");
-    world.generate_world(4, 4); // generate 4x4 chunks
-    world.dump_stats();
-
-    int sample_h = world.sample_height(CHUNK_SIZE_X * 2, CHUNK_SIZE_Z * 2);
-    std::printf("[main] sample height at center = %d\n", sample_h);
 
     if (!glfwInit()) {
         std::fprintf(stderr, "failed to initialize GLFW\n");
@@ -94,14 +90,16 @@ int main(int argc, char** argv) {
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     // initialize WorldRenderer
-    WorldRenderer worldrenderer;
+    // GL のオブジェクトとワーカーを持つので、コンテキストとワールドより先に (1回だけ) 破棄する
+    auto worldrenderer = std::make_unique<WorldRenderer>();
     bool worldRendererReady = false;
-    if (!worldrenderer.init()) {
+    if (!worldrenderer->init()) {
         std::fprintf(stderr, "[main] WorldRenderer::init failed\n");
         // 描画が動作しないが、ワールド自体は初期化済みなので続行は可能
     } else {
         worldRendererReady = true;
     }
+    world.set_unload_callback([&worldrenderer](Chunk& chunk) { worldrenderer->release_chunk(chunk); });
 
     // --- position camera to look at the center of the spawn chunk ---
     {
@@ -125,14 +123,7 @@ int main(int argc, char** argv) {
             target.x, target.y, target.z);
     }
 
-    while(!glfwWindowShouldClose(window)) {
-        float currentFrame = (float)glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-        processInput(window);
-
-        world.update(camera.Position.x, camera.Position.z, viewDistance);
-
+    auto draw_frame = [&]() {
         glClearColor(0.53f, 0.81f, 0.92f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -140,13 +131,45 @@ int main(int argc, char** argv) {
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
         glm::mat4 viewProj = projection * view;
 
-        worldrenderer.render(world, camera.Position, viewProj, viewDistance);
+        worldrenderer->render(world, camera.Position, viewProj, viewDistance);
     
         glfwSwapBuffers(window);
         glfwPollEvents();
+    };
+
+    // スポーン地点の周囲をワーカースレッドで生成し、できたチャンクから順に描画する
+    std::printf("[main] Generating 4x4 world chunks...\n");
+    auto genStart = std::chrono::steady_clock::now();
+    std::vector<uint64_t> chunkHashes = world.generate_world(4, 4, [&](const GenerationProgress& progress) {
+        std::printf("[main] chunk (%d, %d) ready %zu/%zu hash=%016" PRIx64 "\n",
+            progress.cx, progress.cz, progress.done, progress.total, progress.hash);
+        if (!glfwWindowShouldClose(window)) draw_frame();
+    });
+    // チャンクごとのハッシュを座標順にまとめたもの (同じシードなら実行ごとに一致する)
+    uint64_t worldHash = 14695981039346656037ull;
+    for (uint64_t hash : chunkHashes) {
+        worldHash ^= hash;
+        worldHash *= 1099511628211ull;
+    }
+    std::printf("[main] generated %zu chunks in %.1f ms, world hash=%016" PRIx64 "\n", chunkHashes.size(),
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - genStart).count(), worldHash);
+    world.dump_stats();
+
+    int sample_h = world.sample_height(CHUNK_SIZE_X * 2, CHUNK_SIZE_Z * 2);
+    std::printf("[main] sample height at center = %d\n", sample_h);
+
+    while(!glfwWindowShouldClose(window)) {
+        float currentFrame = (float)glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        processInput(window);
+
+        world.update(camera.Position.x, camera.Position.z, viewDistance, camera.Front.x, camera.Front.z);
+        draw_frame();
     }
 
-    worldrenderer.~WorldRenderer();
+    world.set_unload_callback(nullptr);
+    worldrenderer.reset();
     world.destroy();
     glfwDestroyWindow(window);
     glfwTerminate();
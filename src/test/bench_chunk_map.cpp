@@ -0,0 +1,49 @@
+// ChunkMap と以前の std::map<pair<int,int>, ChunkPtr> の検索速度の比較
+// 64x64 個のチャンクを常駐させ、約 35% が外れる 4M 回のランダムな座標で検索する
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+#include "../world/chunk_map.hpp"
+#include "test.hpp"
+
+using namespace ocm;
+
+int main() {
+    constexpr int SIDE = 64;
+    constexpr int LOOKUPS = 4 << 20;
+
+    ChunkMap chunkMap;
+    std::map<std::pair<int, int>, ChunkPtr> stdMap;
+    for (int cz = -SIDE / 2; cz < SIDE / 2; cz++) {
+        for (int cx = -SIDE / 2; cx < SIDE / 2; cx++) {
+            chunkMap.insert_or_assign(cx, cz, std::make_unique<Chunk>(cx, cz));
+            stdMap[{ cx, cz }] = std::make_unique<Chunk>(cx, cz);
+        }
+    }
+
+    // 常駐範囲より少し広い範囲から引く (範囲外が外れになる)
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> coord(-SIDE * 5 / 8, SIDE * 5 / 8 - 1);
+    std::vector<std::pair<int, int>> keys(LOOKUPS);
+    for (auto& key : keys) key = { coord(rng), coord(rng) };
+
+    size_t hitsMap = 0, hitsStd = 0;
+    double msMap = test::best_ms(3, [&] {
+        hitsMap = 0;
+        for (const auto& key : keys) hitsMap += chunkMap.find(key.first, key.second) != nullptr;
+    });
+    double msStd = test::best_ms(3, [&] {
+        hitsStd = 0;
+        for (const auto& key : keys) hitsStd += stdMap.find(key) != stdMap.end();
+    });
+    CHECK(hitsMap == hitsStd);
+
+    std::printf("%d chunks, %d lookups (%.1f%% misses)\n", SIDE * SIDE, LOOKUPS,
+                100.0 * (LOOKUPS - hitsMap) / LOOKUPS);
+    std::printf("  ChunkMap  %8.1f ms  %6.1f M lookups/s\n", msMap, LOOKUPS / msMap / 1e3);
+    std::printf("  std::map  %8.1f ms  %6.1f M lookups/s\n", msStd, LOOKUPS / msStd / 1e3);
+    return test::finish("bench_chunk_map");
+}
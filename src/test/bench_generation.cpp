@@ -0,0 +1,90 @@
+// 地形生成のチャンクあたりの時間 (マイクロ秒)
+// ノイズの層: 2D ノイズに置き換える前の 3D 版 (y 固定の断面) と 2D 版を同じ座標で比べる
+// build_chunk: 全カラムで厳密に計算する場合と粗い格子 (World の既定値) の場合
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "../world/noise.hpp"
+#include "../world/world.hpp"
+#include "test.hpp"
+
+using namespace ocm;
+
+namespace {
+    constexpr int SIDE = 8; // チャンク [-SIDE/2, SIDE/2) x [-SIDE/2, SIDE/2)
+    constexpr int CHUNKS = SIDE * SIDE;
+    constexpr int REPEAT = 5;
+    constexpr int COLUMNS = CHUNK_SIZE_X * CHUNK_SIZE_Z;
+
+    // World::sample_columns の層 (scale, octaves, persistence)
+    struct Layer {
+        float scale;
+        int octaves;
+        float persistence;
+    };
+    constexpr Layer LAYERS[] = {
+        { 0.002f, 3, 0.5f },  // selector
+        { 0.01f, 2, 0.5f },   // humidity
+        { 0.008f, 3, 0.3f },  // lowland
+        { 0.012f, 5, 0.55f }, // mountain
+        { 0.005f, 2, 0.5f },  // river
+    };
+
+    template <class Fn>
+    void for_each_chunk(Fn&& fn) {
+        for (int cz = -SIDE / 2; cz < SIDE / 2; cz++) {
+            for (int cx = -SIDE / 2; cx < SIDE / 2; cx++) fn(cx, cz);
+        }
+    }
+} // namespace
+
+int main() {
+    constexpr uint32_t SEED = 12345;
+
+    std::vector<int> perm(256);
+    std::iota(perm.begin(), perm.end(), 0);
+    std::shuffle(perm.begin(), perm.end(), std::default_random_engine(SEED));
+    perm.insert(perm.end(), perm.begin(), perm.end());
+    const int* p = perm.data();
+    const float offsetX = static_cast<float>(SEED % 10000);
+    const float offsetZ = static_cast<float>((SEED / 10000) % 10000);
+
+    // 全カラムで5つの層を求める (fractal は 3D 版か 2D 版)
+    float noise_x[COLUMNS], noise_z[COLUMNS], result[COLUMNS];
+    float checksum = 0.0f;
+    auto noise_layers = [&](bool use_3d) {
+        for_each_chunk([&](int cx, int cz) {
+            for (const Layer& layer : LAYERS) {
+                for (int i = 0; i < COLUMNS; i++) {
+                    noise_x[i] = static_cast<float>(cx * CHUNK_SIZE_X + i / CHUNK_SIZE_Z) * layer.scale + offsetX;
+                    noise_z[i] = static_cast<float>(cz * CHUNK_SIZE_Z + i % CHUNK_SIZE_Z) * layer.scale + offsetZ;
+                }
+                if (use_3d) fractal_noise_batch(p, noise_x, noise_z, result, COLUMNS, layer.octaves, layer.persistence, 2.0f);
+                else fractal_noise_2d_batch(p, noise_x, noise_z, result, COLUMNS, layer.octaves, layer.persistence, 2.0f);
+                checksum += result[0];
+            }
+        });
+    };
+    double noise3d = test::best_ms(REPEAT, [&] { noise_layers(true); }) * 1e3 / CHUNKS;
+    double noise2d = test::best_ms(REPEAT, [&] { noise_layers(false); }) * 1e3 / CHUNKS;
+
+    World world;
+    world.init(SEED);
+    const int defaultStep = world.noise_sampling();
+    auto build_all = [&] {
+        for_each_chunk([&](int cx, int cz) { world.build_chunk(cx, cz); });
+    };
+    world.set_noise_sampling(0);
+    double buildExact = test::best_ms(REPEAT, build_all) * 1e3 / CHUNKS;
+    world.set_noise_sampling(defaultStep);
+    double buildSampled = test::best_ms(REPEAT, build_all) * 1e3 / CHUNKS;
+
+    std::printf("%d chunks, best of %d runs (ISA: %s)\n", CHUNKS, REPEAT, noise_isa_name(noise_isa()));
+    std::printf("  noise layers: 3D %.1f us -> 2D %.1f us per chunk (x%.2f)\n", noise3d, noise2d, noise3d / noise2d);
+    std::printf("  build_chunk:  exact %.1f us -> step %d %.1f us per chunk (x%.2f)\n",
+                buildExact, defaultStep, buildSampled, buildExact / buildSampled);
+    std::printf("  (checksum %.3f)\n", checksum);
+    return test::finish("bench_generation");
+}
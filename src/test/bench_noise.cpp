@@ -0,0 +1,52 @@
+// noise.hpp のまとめて計算する版の命令セットごとの速度 (M samples/s)
+// fractal は1点 (全オクターブ分) を1サンプルとして数える
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "../world/noise.hpp"
+#include "test.hpp"
+
+using namespace ocm;
+
+int main() {
+    constexpr size_t N = 1 << 16;
+    constexpr int OCTAVES = 5;
+    constexpr int REPEAT = 20;
+
+    std::vector<int> perm(256);
+    std::iota(perm.begin(), perm.end(), 0);
+    std::shuffle(perm.begin(), perm.end(), std::default_random_engine(12345));
+    perm.insert(perm.end(), perm.begin(), perm.end());
+    const int* p = perm.data();
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(0.0f, 10000.0f);
+    std::vector<float> x(N), y(N), z(N), out(N);
+    for (size_t i = 0; i < N; i++) {
+        x[i] = coord(rng);
+        y[i] = coord(rng);
+        z[i] = coord(rng);
+    }
+
+    const NoiseIsa best = noise_isa();
+    std::printf("%zu points, best of %d runs (widest ISA: %s)\n", N, REPEAT, noise_isa_name(best));
+    std::printf("  %-8s %12s %12s %12s %12s\n", "", "perlin", "perlin_2d", "fractal", "fractal_2d");
+    for (NoiseIsa isa : { NoiseIsa::SCALAR, NoiseIsa::SSE2, NoiseIsa::AVX2 }) {
+        if (static_cast<int>(isa) > static_cast<int>(best)) continue;
+        auto rate = [&](auto&& fn) { return N / test::best_ms(REPEAT, fn) / 1e3; };
+        double perlin = rate([&] { perlin_noise_batch(p, x.data(), y.data(), z.data(), out.data(), N, isa); });
+        double perlin2d = rate([&] { perlin_noise_2d_batch(p, x.data(), z.data(), out.data(), N, isa); });
+        double fractal = rate([&] {
+            fractal_noise_batch(p, x.data(), z.data(), out.data(), N, OCTAVES, 0.5f, 2.0f, isa);
+        });
+        double fractal2d = rate([&] {
+            fractal_noise_2d_batch(p, x.data(), z.data(), out.data(), N, OCTAVES, 0.5f, 2.0f, isa);
+        });
+        std::printf("  %-8s %10.1f M %10.1f M %10.1f M %10.1f M  samples/s\n",
+                    noise_isa_name(isa), perlin, perlin2d, fractal, fractal2d);
+    }
+    std::printf("  (fractal: %d octaves per sample)\n", OCTAVES);
+    return test::finish("bench_noise");
+}
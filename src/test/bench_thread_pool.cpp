@@ -0,0 +1,130 @@
+// 小さなタスクを大量に流したときの ThreadPool の1タスクあたりのコスト
+// 比較対象は置き換える前のプール (1つのミューテックスと std::queue<std::function>、投入ごとに packaged_task)
+//   bench_thread_pool [ワーカー数 (既定 2)] [タスク数 (既定 1M)]
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "../util/thread_pool.hpp"
+#include "test.hpp"
+
+// 置き換える前の util::ThreadPool (比較用にそのまま残したもの)
+class LegacyThreadPool {
+    public:
+        explicit LegacyThreadPool(size_t threads) : stop(false) {
+            for (size_t i = 0; i < threads; i++) {
+                workers.emplace_back([this] {
+                    for (;;) {
+                        std::function<void()> task;
+                        {
+                            std::unique_lock<std::mutex> lock(this->queue_mutex);
+                            this->condition.wait(lock, [this] { return this->stop || !this->tasks.empty(); });
+                            if (this->stop && this->tasks.empty()) return;
+                            task = std::move(this->tasks.front());
+                            this->tasks.pop();
+                        }
+                        task();
+                    }
+                });
+            }
+        }
+
+        template<class F>
+        auto enqueue(F&& f) -> std::future<void> {
+            auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                if (stop) throw std::runtime_error("enqueue on stopped ThreadPool");
+                tasks.emplace([task]() { (*task)(); });
+            }
+            condition.notify_one();
+            return task->get_future();
+        }
+
+        ~LegacyThreadPool() {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                stop = true;
+            }
+            condition.notify_all();
+            for (std::thread& worker : workers) worker.join();
+        }
+
+    private:
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> tasks;
+        std::mutex queue_mutex;
+        std::condition_variable condition;
+        bool stop;
+};
+
+static constexpr size_t BATCH = 256;
+static constexpr size_t FANOUT = 16; // nested: 1つのタスクが投入する子タスク数
+
+// 全タスクの完了待ち
+static void wait_for(const std::atomic<size_t>& done, size_t count) {
+    while (done.load(std::memory_order_acquire) < count) std::this_thread::yield();
+}
+
+int main(int argc, char** argv) {
+    const size_t threads = argc >= 2 ? std::strtoul(argv[1], nullptr, 10) : 2;
+    const size_t tasks = argc >= 3 ? std::strtoul(argv[2], nullptr, 10) : (size_t(1) << 20);
+
+    std::atomic<size_t> done{0};
+    auto count = [&done]() { done.fetch_add(1, std::memory_order_release); };
+
+    double legacyMs = test::best_ms(3, [&] {
+        LegacyThreadPool pool(threads);
+        done = 0;
+        for (size_t i = 0; i < tasks; i++) pool.enqueue(count);
+        wait_for(done, tasks);
+    });
+
+    double submitMs = test::best_ms(3, [&] {
+        util::ThreadPool pool(threads);
+        done = 0;
+        for (size_t i = 0; i < tasks; i++) pool.submit(count);
+        wait_for(done, tasks);
+    });
+
+    double batchMs = test::best_ms(3, [&] {
+        util::ThreadPool pool(threads);
+        done = 0;
+        std::vector<util::ThreadPool::Job> jobs;
+        for (size_t i = 0; i < tasks; i += BATCH) {
+            for (size_t j = i; j < tasks && j < i + BATCH; j++) jobs.push_back({ count, util::Priority::NORMAL, {} });
+            pool.submit_batch(jobs);
+        }
+        wait_for(done, tasks);
+    });
+
+    // ワーカーが子タスクを自分のキューへ投入する (外から投入するのは tasks / FANOUT 個)
+    double nestedMs = test::best_ms(3, [&] {
+        util::ThreadPool pool(threads);
+        done = 0;
+        for (size_t i = 0; i < tasks / FANOUT; i++) {
+            pool.submit([&pool, &count]() {
+                for (size_t k = 0; k < FANOUT; k++) pool.submit(count);
+            });
+        }
+        wait_for(done, tasks / FANOUT * FANOUT);
+    });
+
+    std::printf("%zu empty tasks on %zu workers (hardware threads: %u)\n",
+                tasks, threads, std::thread::hardware_concurrency());
+    auto row = [&](const char* name, double ms) {
+        std::printf("  %-22s %8.1f ms  %6.1f M tasks/s\n", name, ms, tasks / ms / 1e3);
+    };
+    row("legacy enqueue", legacyMs);
+    row("submit", submitMs);
+    row("submit_batch (256)", batchMs);
+    row("nested submit (x16)", nestedMs);
+    return test::finish("bench_thread_pool");
+}
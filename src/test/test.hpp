@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+// テストとベンチマークの共通部分 (ゲーム本体の SRC には含めない)
+namespace test {
+    inline int& failure_count() {
+        static int count = 0;
+        return count;
+    }
+
+    inline void report_failure(const char* file, int line, const char* expr) {
+        std::printf("%s:%d: CHECK failed: %s\n", file, line, expr);
+        failure_count()++;
+    }
+
+    // main の最後に呼ぶ (終了コードを返す)
+    inline int finish(const char* name) {
+        if (failure_count() == 0) {
+            std::printf("[%s] OK\n", name);
+            return 0;
+        }
+        std::printf("[%s] %d check(s) failed\n", name, failure_count());
+        return 1;
+    }
+
+    // fn を repeat 回実行して最も速かった時間 (ミリ秒)
+    template <class Fn>
+    double best_ms(int repeat, Fn&& fn) {
+        double best = 1e30;
+        for (int r = 0; r < repeat; r++) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (ms < best) best = ms;
+        }
+        return best;
+    }
+} // namespace test
+
+#define CHECK(expr) do { if (!(expr)) ::test::report_failure(__FILE__, __LINE__, #expr); } while (0)
@@ -0,0 +1,233 @@
+// BufferArena (GL に触れない区間アロケータ) のテスト
+//  確保は最初に収まる区間から、解放は前後の空きと結合、resize は直後の空きへ伸ばす
+//  compact の Move を順にコピーすれば、どの区間の中身も壊れない
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "../gfx/buffer_arena.hpp"
+#include "test.hpp"
+
+using gfx::BufferArena;
+using Handle = BufferArena::Handle;
+
+namespace {
+    constexpr size_t MAX_CAPACITY = 4096;
+
+    // バッファの中身の代わり (各単位に持ち主の Handle を書いておく)
+    struct Memory {
+        std::vector<int64_t> cells = std::vector<int64_t>(MAX_CAPACITY, -1);
+
+        void fill(const BufferArena& arena, Handle h) {
+            std::fill_n(cells.begin() + static_cast<std::ptrdiff_t>(arena.offset(h)), arena.size(h), static_cast<int64_t>(h));
+        }
+        // Move を戻り値の順に適用する (前へ詰めるので先頭から1単位ずつコピー)
+        void apply(const std::vector<BufferArena::Move>& moves) {
+            for (const auto& m : moves) {
+                for (size_t i = 0; i < m.size; i++) cells[m.to + i] = cells[m.from + i];
+            }
+        }
+        bool holds(const BufferArena& arena, Handle h) const {
+            for (size_t i = 0; i < arena.size(h); i++) {
+                if (cells[arena.offset(h) + i] != static_cast<int64_t>(h)) return false;
+            }
+            return true;
+        }
+    };
+
+    // 生きている区間が容量の内にあり、互いに重ならない
+    bool disjoint(const BufferArena& arena, std::vector<Handle> live) {
+        std::sort(live.begin(), live.end(), [&](Handle a, Handle b) { return arena.offset(a) < arena.offset(b); });
+        size_t end = 0;
+        for (Handle h : live) {
+            if (arena.offset(h) < end) return false;
+            end = arena.offset(h) + arena.size(h);
+        }
+        return end <= arena.capacity();
+    }
+
+    void test_allocate_free() {
+        BufferArena arena(100);
+        Handle a = arena.allocate(10);
+        Handle b = arena.allocate(20);
+        Handle c = arena.allocate(30);
+        Handle d = arena.allocate(40);
+        CHECK(arena.offset(a) == 0 && arena.offset(b) == 10 && arena.offset(c) == 30 && arena.offset(d) == 60);
+        CHECK(arena.used() == 100);
+        CHECK(arena.allocate(1) == BufferArena::INVALID);
+        CHECK(arena.allocate(0) == BufferArena::INVALID);
+        CHECK(arena.fragmentation() == 0.0f);
+
+        // 穴が2つ: [0, 10) と [30, 60)。最初に収まる区間から確保する
+        arena.free(a);
+        arena.free(c);
+        CHECK(arena.largest_free() == 30);
+        CHECK(arena.fragmentation() > 0.0f);
+        Handle e = arena.allocate(5);
+        CHECK(arena.offset(e) == 0);
+        Handle f = arena.allocate(8);
+        CHECK(arena.offset(f) == 30); // [5, 10) には収まらない
+        arena.free(e);
+        arena.free(f);
+        CHECK(arena.allocation_count() == 2);
+
+        // b を解放すると前 [0, 10) と後 [30, 60) の両方と結合する
+        arena.free(b);
+        CHECK(arena.largest_free() == 60);
+        CHECK(arena.fragmentation() == 0.0f);
+        Handle g = arena.allocate(60);
+        CHECK(g != BufferArena::INVALID && arena.offset(g) == 0);
+
+        // 二重解放・不正な Handle は無視する
+        arena.free(d);
+        arena.free(d);
+        arena.free(BufferArena::INVALID);
+        CHECK(arena.used() == 60);
+        CHECK(arena.allocation_count() == 1);
+    }
+
+    void test_resize() {
+        BufferArena arena(64);
+        Handle a = arena.allocate(10);
+        Handle b = arena.allocate(10);
+        Handle c = arena.allocate(10); // [20, 30)
+        arena.free(b);                 // 空き [10, 20) と [30, 64)
+
+        // 直後の空きへ伸ばす
+        CHECK(arena.resize(a, 15));
+        CHECK(arena.offset(a) == 0 && arena.size(a) == 15);
+        CHECK(arena.resize(a, 20));
+        CHECK(arena.used() == 30);
+        // 直後は c が使っているので伸ばせない (大きさも変わらない)
+        CHECK(!arena.resize(a, 21));
+        CHECK(arena.size(a) == 20);
+
+        // 縮めた分は空きに戻り、後ろの空きとも結合する
+        CHECK(arena.resize(c, 4));
+        CHECK(arena.used() == 24);
+        CHECK(arena.largest_free() == 40);
+        CHECK(arena.resize(c, 44));
+        CHECK(arena.offset(c) == 20 && arena.used() == 64);
+        CHECK(!arena.resize(c, 45));
+        CHECK(!arena.resize(c, 0));
+    }
+
+    void test_grow() {
+        BufferArena arena(16);
+        Handle a = arena.allocate(12);
+        CHECK(arena.allocate(8) == BufferArena::INVALID);
+        arena.grow(8); // 縮めることはない
+        CHECK(arena.capacity() == 16);
+
+        // 足した空きは末尾の空きと結合する
+        arena.grow(32);
+        CHECK(arena.capacity() == 32);
+        CHECK(arena.largest_free() == 20);
+        Handle b = arena.allocate(20);
+        CHECK(arena.offset(b) == 12);
+        // 末尾の区間は grow の後で伸ばせる
+        CHECK(!arena.resize(b, 24));
+        arena.grow(40);
+        CHECK(arena.resize(b, 28));
+        CHECK(arena.offset(a) == 0 && arena.used() == 40);
+    }
+
+    void test_compact() {
+        BufferArena arena(200);
+        Memory memory;
+        std::vector<Handle> handles;
+        for (size_t size : { 7, 13, 5, 20, 11, 9, 30, 4, 16, 25 }) {
+            handles.push_back(arena.allocate(size));
+            memory.fill(arena, handles.back());
+        }
+        // 1つおきに解放して穴だらけにする
+        std::vector<Handle> live;
+        for (size_t i = 0; i < handles.size(); i++) {
+            if (i % 2 == 0) arena.free(handles[i]);
+            else live.push_back(handles[i]);
+        }
+        const float before = arena.fragmentation();
+        CHECK(before > 0.0f);
+
+        // 1回に動かす量を制限すると、残りは次の compact へ持ち越す
+        std::vector<BufferArena::Move> moves = arena.compact(20);
+        CHECK(!moves.empty());
+        size_t moved = 0;
+        for (const auto& m : moves) {
+            CHECK(m.to < m.from);
+            CHECK(arena.offset(m.handle) == m.to && arena.size(m.handle) == m.size);
+            moved += m.size;
+        }
+        CHECK(moved <= 20 || moves.size() == 1);
+        memory.apply(moves);
+        for (Handle h : live) CHECK(memory.holds(arena, h));
+        CHECK(disjoint(arena, live));
+        CHECK(arena.fragmentation() <= before); // 末尾の空きはまだ最大のまま
+
+        // 繰り返すと (最後は制限なし) 空きは末尾の1つにまとまる。Move は前から順に並ぶ
+        int rounds = 0;
+        while (!(moves = arena.compact(20)).empty() && rounds < 10) {
+            for (size_t i = 1; i < moves.size(); i++) CHECK(moves[i - 1].to < moves[i].to);
+            memory.apply(moves);
+            rounds++;
+        }
+        moves = arena.compact();
+        memory.apply(moves);
+        CHECK(arena.compact().empty());
+        for (Handle h : live) CHECK(memory.holds(arena, h));
+        CHECK(arena.fragmentation() == 0.0f);
+        CHECK(arena.largest_free() == arena.capacity() - arena.used());
+        Handle tail = arena.allocate(arena.largest_free());
+        CHECK(tail != BufferArena::INVALID && arena.offset(tail) == arena.used() - arena.size(tail));
+    }
+
+    // 確保・解放・伸縮・詰め直しをランダムに繰り返し、重なりと中身の保存を確かめる
+    void test_random() {
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<int> op(0, 9);
+        std::uniform_int_distribution<size_t> size(1, 24);
+        BufferArena arena(256);
+        Memory memory;
+        std::vector<Handle> live;
+        for (int step = 0; step < 20000; step++) {
+            int o = op(rng);
+            if (o < 4) {
+                Handle h = arena.allocate(size(rng));
+                if (h == BufferArena::INVALID) {
+                    if (arena.capacity() < MAX_CAPACITY) arena.grow(arena.capacity() * 2);
+                    continue;
+                }
+                live.push_back(h);
+                memory.fill(arena, h);
+            } else if (o < 7 && !live.empty()) {
+                size_t i = rng() % live.size();
+                arena.free(live[i]);
+                live.erase(live.begin() + static_cast<std::ptrdiff_t>(i));
+            } else if (o < 9 && !live.empty()) {
+                Handle h = live[rng() % live.size()];
+                if (arena.resize(h, size(rng))) memory.fill(arena, h);
+            } else {
+                memory.apply(arena.compact(rng() % 64));
+            }
+            if (step % 97 == 0) {
+                CHECK(disjoint(arena, live));
+                size_t used = 0;
+                for (Handle h : live) {
+                    used += arena.size(h);
+                    CHECK(memory.holds(arena, h));
+                }
+                CHECK(used == arena.used());
+                CHECK(arena.allocation_count() == live.size());
+            }
+        }
+    }
+} // namespace
+
+int main() {
+    test_allocate_free();
+    test_resize();
+    test_grow();
+    test_compact();
+    test_random();
+    return test::finish("test_buffer_arena");
+}
@@ -0,0 +1,131 @@
+// CubeRenderer::build_draw_lists (描画コンテキストなしで組み立てられる描画コマンド) のテスト
+#include <cstdio>
+#include <vector>
+#include "../gfx/cube_renderer.hpp"
+#include "test.hpp"
+
+using gfx::BufferArena;
+using gfx::CubeRenderer;
+using gfx::DrawList;
+using ocm::Chunk;
+
+// セクションごとの四角形の区間 (四角形単位の累積)
+//   s0: [0, 10)  s1: 空  s2: [10, 25)  s3: [25, 40)  s4, s5: 空  s6: [40, 50)  s7: [50, 60)
+static const std::array<uint32_t, ocm::SECTION_COUNT + 1> QUADS = { 0, 10, 10, 25, 40, 40, 40, 50, 60 };
+
+struct Command {
+    GLsizei count;
+    GLint base;
+    bool operator==(const Command& other) const { return count == other.count && base == other.base; }
+};
+
+static std::vector<Command> commands(const DrawList& list) {
+    std::vector<Command> out;
+    for (size_t i = 0; i < list.size(); i++) {
+        out.push_back({ list.counts[i], list.base_vertices[i] });
+        CHECK(list.offsets[i] == nullptr);
+    }
+    return out;
+}
+
+// 四角形の区間 [first, last) の描画コマンド (base は粒の位置 << GRANULE_SHIFT + first * 4)
+static Command quads(const BufferArena& arena, BufferArena::Handle handle, uint32_t first, uint32_t last) {
+    GLint base = static_cast<GLint>(arena.offset(handle) << CubeRenderer::GRANULE_SHIFT) + static_cast<GLint>(first * 4);
+    return { static_cast<GLsizei>((last - first) * 6), base };
+}
+
+static uint8_t bits(std::initializer_list<int> sections) {
+    uint8_t mask = 0;
+    for (int s : sections) mask |= static_cast<uint8_t>(1u << s);
+    return mask;
+}
+
+int main() {
+    BufferArena arena(1024);
+    // 先頭を埋めておき、チャンクの区間が 0 以外の位置から始まるようにする
+    arena.allocate(5);
+    BufferArena::Handle handleA = arena.allocate(4);
+    arena.allocate(3);
+    BufferArena::Handle handleB = arena.allocate(2);
+    BufferArena::Handle handleT = arena.allocate(2);
+    CHECK(arena.offset(handleA) == 5);
+    CHECK(arena.offset(handleB) == 12);
+    CHECK(arena.offset(handleT) == 14);
+
+    // A: 16bit インデックス、B: 32bit インデックス (四角形の並びは同じ)
+    Chunk a(0, 0), b(1, 0);
+    a.mesh = handleA;
+    a.indexCount = 60 * 6;
+    a.index_type = GL_UNSIGNED_SHORT;
+    a.section_quads = QUADS;
+    b.mesh = handleB;
+    b.indexCount = 60 * 6;
+    b.index_type = GL_UNSIGNED_INT;
+    b.section_quads = QUADS;
+
+    std::vector<Chunk*> chunks = { &a };
+    DrawList list16, list32;
+    auto build = [&](std::vector<uint8_t> sections) {
+        CubeRenderer::build_draw_lists(chunks, sections, false, arena, list16, list32);
+    };
+
+    // 全て見えていれば1コマンド
+    build({ 0xFF });
+    CHECK(commands(list16) == (std::vector<Command>{ quads(arena, handleA, 0, 60) }));
+    CHECK(list32.empty());
+
+    // 隣り合う見えるセクションはつなぐ
+    build({ bits({ 2, 3 }) });
+    CHECK(commands(list16) == (std::vector<Command>{ quads(arena, handleA, 10, 40) }));
+
+    // 空のセクションは見えていなくてもつながりを切らない (s1 / s4, s5)
+    build({ bits({ 0, 2 }) });
+    CHECK(commands(list16) == (std::vector<Command>{ quads(arena, handleA, 0, 25) }));
+    build({ bits({ 0, 1, 2 }) });
+    CHECK(commands(list16) == (std::vector<Command>{ quads(arena, handleA, 0, 25) }));
+    build({ bits({ 3, 6 }) });
+    CHECK(commands(list16) == (std::vector<Command>{ quads(arena, handleA, 25, 50) }));
+
+    // カリングされた (中身のある) セクションで分かれる
+    build({ bits({ 0, 2, 6 }) });
+    CHECK(commands(list16) == (std::vector<Command>{ quads(arena, handleA, 0, 25), quads(arena, handleA, 40, 50) }));
+    build({ bits({ 0, 3, 7 }) });
+    CHECK(commands(list16) == (std::vector<Command>{
+        quads(arena, handleA, 0, 10), quads(arena, handleA, 25, 40), quads(arena, handleA, 50, 60) }));
+
+    // base は区間の先頭の粒 (5) の頂点位置 + セクションの先頭の四角形 (25) * 4
+    build({ bits({ 3 }) });
+    CHECK(list16.size() == 1 && list16.base_vertices[0] == 5 * 64 + 25 * 4 && list16.counts[0] == 15 * 6);
+
+    // 見えるセクションがなければ何も出さない (空のセクションだけ見えている場合も)
+    build({ 0 });
+    CHECK(list16.empty());
+    build({ bits({ 1, 4, 5 }) });
+    CHECK(list16.empty());
+
+    // インデックスの型で振り分ける (前回の中身は消える)
+    chunks = { &a, &b };
+    build({ bits({ 0 }), bits({ 7 }) });
+    CHECK(commands(list16) == (std::vector<Command>{ quads(arena, handleA, 0, 10) }));
+    CHECK(commands(list32) == (std::vector<Command>{ quads(arena, handleB, 50, 60) }));
+
+    // メッシュのないチャンクは飛ばす
+    b.indexCount = 0;
+    build({ 0xFF, 0xFF });
+    CHECK(commands(list16) == (std::vector<Command>{ quads(arena, handleA, 0, 60) }));
+    CHECK(list32.empty());
+
+    // 半透明は trans_* を使う
+    Chunk t(2, 0);
+    t.trans_mesh = handleT;
+    t.trans_indexCount = 8 * 6;
+    t.trans_index_type = GL_UNSIGNED_INT;
+    t.trans_section_quads = { 0, 0, 0, 0, 5, 8, 8, 8, 8 };
+    chunks = { &a, &t };
+    CubeRenderer::build_draw_lists(chunks, { 0xFF, 0xFF }, true, arena, list16, list32);
+    CHECK(list16.empty());
+    CHECK(commands(list32) == (std::vector<Command>{ quads(arena, handleT, 0, 8) }));
+    CHECK(list32.base_vertices[0] == 14 * 64);
+
+    return test::finish("test_draw_list");
+}
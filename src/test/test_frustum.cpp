@@ -0,0 +1,110 @@
+// gfx::Frustum のテスト
+// 既知の箱の classify の結果と、ランダムな行列・箱で test_boxes が classify と一致するか
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../gfx/frustum.hpp"
+#include "test.hpp"
+
+using gfx::AABB;
+using gfx::Frustum;
+using Result = gfx::Frustum::Result;
+
+static AABB box(float x0, float y0, float z0, float x1, float y1, float z1) {
+    return { glm::vec3(x0, y0, z0), glm::vec3(x1, y1, z1) };
+}
+
+// test_boxes の結果 (bit) が classify != OUTSIDE と一致するか
+static bool agrees(const Frustum& frustum, const std::vector<AABB>& boxes) {
+    uint32_t bits = frustum.test_boxes(boxes.data(), static_cast<int>(boxes.size()));
+    for (size_t k = 0; k < boxes.size(); k++) {
+        bool visible = frustum.classify(boxes[k]) != Result::OUTSIDE;
+        if (((bits >> k) & 1u) != static_cast<uint32_t>(visible)) return false;
+    }
+    // count より上のビットは立たない
+    return boxes.size() >= 32 || (bits >> boxes.size()) == 0;
+}
+
+static void test_known_boxes() {
+    // 原点から -z を向く、縦横 90 度・近 0.1・遠 100 の視錐台
+    // 距離 d の断面は x, y とも [-d, d]
+    const float QUARTER = 1.5707964f;
+    glm::mat4 proj = glm::perspective(QUARTER, 1.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(proj * view);
+
+    CHECK(frustum.classify(box(-1, -1, -11, 1, 1, -9)) == Result::INSIDE);
+    CHECK(frustum.classify(box(-5, -5, -50, 5, 5, -40)) == Result::INSIDE);
+    // 背後・遠平面の先・横の外
+    CHECK(frustum.classify(box(-1, -1, 9, 1, 1, 11)) == Result::OUTSIDE);
+    CHECK(frustum.classify(box(-1, -1, -200, 1, 1, -150)) == Result::OUTSIDE);
+    CHECK(frustum.classify(box(20, -1, -11, 22, 1, -9)) == Result::OUTSIDE);
+    CHECK(frustum.classify(box(-1, -30, -11, 1, -20, -9)) == Result::OUTSIDE);
+    // 左の平面・近平面・遠平面をまたぐ
+    CHECK(frustum.classify(box(-20, -1, -11, 0, 1, -9)) == Result::INTERSECT);
+    CHECK(frustum.classify(box(-0.01f, -0.01f, -1, 0.01f, 0.01f, 1)) == Result::INTERSECT);
+    CHECK(frustum.classify(box(-1, -1, -110, 1, 1, -90)) == Result::INTERSECT);
+    // 視錐台全体を含む箱
+    CHECK(frustum.classify(box(-1000, -1000, -1000, 1000, 1000, 1000)) == Result::INTERSECT);
+    CHECK(frustum.intersects(box(-1, -1, -11, 1, 1, -9)));
+    CHECK(!frustum.intersects(box(-1, -1, 9, 1, 1, 11)));
+
+    // 上の箱をまとめて判定 (bit k が classify と一致する)
+    std::vector<AABB> boxes = {
+        box(-1, -1, -11, 1, 1, -9), box(-1, -1, 9, 1, 1, 11), box(-20, -1, -11, 0, 1, -9),
+        box(-1, -1, -200, 1, 1, -150), box(-1000, -1000, -1000, 1000, 1000, 1000),
+    };
+    CHECK(frustum.test_boxes(boxes.data(), static_cast<int>(boxes.size())) == 0b10101u);
+    CHECK(frustum.test_boxes(boxes.data(), 0) == 0);
+}
+
+static void test_random_boxes() {
+    std::mt19937 rng(2024);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> pos(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> extent(0.0f, 40.0f);
+
+    int mismatches = 0;
+    int counts[3] = {};
+    for (int m = 0; m < 2000; m++) {
+        glm::mat4 viewProj;
+        if (m % 4 != 3) {
+            // 透視投影のカメラ
+            glm::vec3 eye(pos(rng), pos(rng) * 0.5f, pos(rng));
+            glm::vec3 dir(unit(rng), unit(rng), unit(rng));
+            if (glm::length(dir) < 0.1f) dir = glm::vec3(1.0f, 0.0f, 0.0f);
+            float fov = 0.3f + (unit(rng) + 1.0f) * 0.7f;
+            float aspect = 0.5f + (unit(rng) + 1.0f);
+            viewProj = glm::perspective(fov, aspect, 0.1f, 100.0f + (unit(rng) + 1.0f) * 400.0f)
+                     * glm::lookAt(eye, eye + dir, glm::vec3(0.0f, 1.0f, 0.0f));
+        } else {
+            // 任意の行列 (平面が傾いていたり退化していたりしても一致する)
+            for (int c = 0; c < 4; c++) {
+                for (int r = 0; r < 4; r++) viewProj[c][r] = unit(rng);
+            }
+        }
+        Frustum frustum(viewProj);
+
+        // 32 個ちょうどと端数の両方
+        int count = (m % 2) ? 32 : 1 + static_cast<int>(rng() % 31);
+        std::vector<AABB> boxes;
+        for (int k = 0; k < count; k++) {
+            glm::vec3 lo(pos(rng), pos(rng), pos(rng));
+            boxes.push_back({ lo, lo + glm::vec3(extent(rng), extent(rng), extent(rng)) });
+            counts[static_cast<int>(frustum.classify(boxes.back()))]++;
+        }
+        if (!agrees(frustum, boxes)) mismatches++;
+    }
+    CHECK(mismatches == 0);
+    // 3 種類の結果がどれも十分に出ている
+    CHECK(counts[0] > 1000 && counts[1] > 1000 && counts[2] > 100);
+    std::printf("random boxes: outside %d, intersect %d, inside %d\n", counts[0], counts[1], counts[2]);
+}
+
+int main() {
+    test_known_boxes();
+    test_random_boxes();
+    return test::finish("test_frustum");
+}
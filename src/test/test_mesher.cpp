@@ -0,0 +1,193 @@
+// WorldRenderer::build_mesh_data のメッシュ生成方式どうしの比較
+//  BINARY: 頂点バッファが PER_FACE と完全に一致する
+//  GREEDY: 結合した四角形を1ブロック分の面に分けると PER_FACE と同じ面の集合になる
+// 複数のシードで生成したチャンク (生成範囲の端・内側) と、水・サボテン・葉を混ぜた手作りのチャンクで試す
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+#include "../world/world.hpp"
+#include "../world/world_renderer.hpp"
+#include "test.hpp"
+
+using namespace ocm;
+
+namespace {
+    constexpr int REGION = 4; // シードごとに生成するチャンク [0, REGION) x [0, REGION)
+
+    // 試した範囲 (全て 0 でないことを最後に確かめる)
+    struct Coverage {
+        size_t chunks = 0;
+        size_t hidden_sections = 0;
+        size_t water_faces = 0;
+        size_t cactus_faces = 0;
+        size_t merged_quads = 0; // GREEDY で2ブロック以上に結合した四角形
+    } coverage;
+
+    // 1ブロック分の面 (バッファ・向き・テクスチャ層・lower/inset・ブロックの位置) を1つの整数にする
+    uint64_t face_key(bool translucent, int face, uint32_t layer, uint32_t flags, int x, int y, int z) {
+        return static_cast<uint64_t>(translucent) << 40 | static_cast<uint64_t>(face) << 37
+             | static_cast<uint64_t>(layer) << 29 | static_cast<uint64_t>(flags) << 27
+             | static_cast<uint64_t>(x) << 18 | static_cast<uint64_t>(y) << 9 | static_cast<uint64_t>(z);
+    }
+
+    // 四角形 (4頂点) を1ブロック分の面に分けて keys に加える
+    // 面の向きごとに、格子点の範囲から面を出したブロックの範囲を求める (Chunk::add_quad の逆)
+    void split_quads(const std::vector<gfx::PackedVertex>& vertices, bool translucent, std::vector<uint64_t>& keys) {
+        CHECK(vertices.size() % 4 == 0);
+        for (size_t q = 0; q + 4 <= vertices.size(); q += 4) {
+            int lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+            int max_u = 0, max_v = 0;
+            uint32_t flags = 0;
+            const int face = (vertices[q].lo >> 18) & 7;
+            const uint32_t layer = (vertices[q].hi >> 16) & 255;
+            for (size_t i = q; i < q + 4; i++) {
+                const gfx::PackedVertex& v = vertices[i];
+                const int pos[3] = { static_cast<int>(v.lo & 31), static_cast<int>((v.lo >> 5) & 255),
+                                     static_cast<int>((v.lo >> 13) & 31) };
+                for (int a = 0; a < 3; a++) {
+                    lo[a] = std::min(lo[a], pos[a]);
+                    hi[a] = std::max(hi[a], pos[a]);
+                }
+                max_u = std::max(max_u, static_cast<int>(v.hi & 255));
+                max_v = std::max(max_v, static_cast<int>((v.hi >> 8) & 255));
+                flags |= (v.lo >> 21) & 3;
+                CHECK(static_cast<int>((v.lo >> 18) & 7) == face);
+                CHECK(((v.hi >> 16) & 255) == layer);
+            }
+
+            // 法線方向の軸と、面が載る格子面から見たブロックの側 (TOP・FRONT・RIGHT は1つ手前)
+            int n = 0, back = 0;
+            switch (face) {
+                case SIDE_FRONT: n = 2; back = 1; break;
+                case SIDE_BACK:  n = 2; break;
+                case TOP:        n = 1; back = 1; break;
+                case BOTTOM:     n = 1; break;
+                case SIDE_RIGHT: n = 0; back = 1; break;
+                case SIDE_LEFT:  n = 0; break;
+                default: CHECK(false); continue;
+            }
+            CHECK(lo[n] == hi[n]);
+            lo[n] -= back;
+            hi[n] = lo[n] + 1;
+            // UV は結合した面の大きさ (テクスチャを繰り返す回数)
+            const int cells = (hi[0] - lo[0]) * (hi[1] - lo[1]) * (hi[2] - lo[2]);
+            CHECK(max_u * max_v == cells);
+            if (cells > 1) coverage.merged_quads++;
+
+            for (int x = lo[0]; x < hi[0]; x++) {
+                for (int y = lo[1]; y < hi[1]; y++) {
+                    for (int z = lo[2]; z < hi[2]; z++) keys.push_back(face_key(translucent, face, layer, flags, x, y, z));
+                }
+            }
+        }
+    }
+
+    std::vector<uint64_t> unit_faces(const gfx::MeshData& mesh) {
+        std::vector<uint64_t> keys;
+        split_quads(mesh.opaque_vertices, false, keys);
+        split_quads(mesh.trans_vertices, true, keys);
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    bool same_vertices(const std::vector<gfx::PackedVertex>& a, const std::vector<gfx::PackedVertex>& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a[i].lo != b[i].lo || a[i].hi != b[i].hi) return false;
+        }
+        return true;
+    }
+
+    void compare_modes(const ChunkSnapshot& snapshot) {
+        gfx::MeshData perFace = WorldRenderer::build_mesh_data(snapshot, MeshMode::PER_FACE);
+        gfx::MeshData binary = WorldRenderer::build_mesh_data(snapshot, MeshMode::BINARY);
+        gfx::MeshData greedy = WorldRenderer::build_mesh_data(snapshot, MeshMode::GREEDY);
+
+        bool ok = same_vertices(binary.opaque_vertices, perFace.opaque_vertices)
+               && same_vertices(binary.trans_vertices, perFace.trans_vertices);
+        if (!ok) std::printf("BINARY != PER_FACE: chunk (%d, %d)\n", snapshot.cx, snapshot.cz);
+        CHECK(ok);
+        CHECK(binary.opaque_sections == perFace.opaque_sections);
+        CHECK(binary.trans_sections == perFace.trans_sections);
+        CHECK(binary.face_count == perFace.face_count);
+
+        std::vector<uint64_t> faces = unit_faces(perFace);
+        ok = unit_faces(greedy) == faces;
+        if (!ok) std::printf("GREEDY covers different faces: chunk (%d, %d)\n", snapshot.cx, snapshot.cz);
+        CHECK(ok);
+        CHECK(greedy.face_count == perFace.face_count);
+        CHECK(greedy.opaque_vertices.size() + greedy.trans_vertices.size()
+              <= perFace.opaque_vertices.size() + perFace.trans_vertices.size());
+
+        coverage.chunks++;
+        for (bool hidden : snapshot.section_hidden) coverage.hidden_sections += hidden;
+        coverage.water_faces += perFace.trans_vertices.size() / 4;
+        for (size_t i = 0; i < perFace.opaque_vertices.size(); i += 4) {
+            coverage.cactus_faces += (perFace.opaque_vertices[i].lo >> 22) & 1; // 側面 (inset)
+        }
+    }
+
+    // 水・サボテン・葉・不透明ブロックを混ぜた手作りのチャンク (隣接チャンクの境界・最上段と最下段も埋める)
+    void fill_mixed(ChunkSnapshot& snapshot, uint32_t seed) {
+        static const BlockID ids[] = { BlockID::AIR, BlockID::AIR, BlockID::STONE, BlockID::GRASS,
+                                       BlockID::WATER, BlockID::CACTUS, BlockID::LEAVES };
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> pick(0, static_cast<int>(sizeof(ids) / sizeof(ids[0])) - 1);
+
+        snapshot.cx = -1;
+        snapshot.cz = 2;
+        std::fill(std::begin(snapshot.section_hidden), std::end(snapshot.section_hidden), false);
+        std::fill(std::begin(snapshot.blocks), std::end(snapshot.blocks), static_cast<uint8_t>(BlockID::AIR));
+        for (int y = 0; y < CHUNK_SIZE_Y; y++) {
+            for (int z = -1; z <= CHUNK_SIZE_Z; z++) {
+                for (int x = -1; x <= CHUNK_SIZE_X; x++) {
+                    // 埋まったセクション、結合できる層、ばらばらな層
+                    BlockID id = BlockID::AIR;
+                    if (y < SECTION_SIZE) id = BlockID::STONE;
+                    else if (y < 2 * SECTION_SIZE) id = (x + z) % 5 == 0 ? BlockID::WATER : BlockID::SAND;
+                    else if (y < 4 * SECTION_SIZE || y >= CHUNK_SIZE_Y - 4) id = ids[pick(rng)];
+                    snapshot.blocks[ChunkSnapshot::index(x, y, z)] = static_cast<uint8_t>(id);
+                }
+            }
+        }
+        // 最下段のセクションは全体が石なので面が出ない
+        snapshot.section_hidden[0] = true;
+    }
+} // namespace
+
+int main() {
+    // 生成したチャンク (隣接チャンクが無い生成範囲の端と、四方が揃った内側)
+    for (uint32_t seed : { 12345u, 1u, 777u, 20240601u }) {
+        World world;
+        world.init(seed);
+        for (int cz = 0; cz < REGION; cz++) {
+            for (int cx = 0; cx < REGION; cx++) world.generate_chunk(cx, cz);
+        }
+        auto snapshot = std::make_unique<ChunkSnapshot>();
+        for (int cz = 0; cz < REGION; cz++) {
+            for (int cx = 0; cx < REGION; cx++) {
+                CHECK(snapshot->capture(world, cx, cz));
+                compare_modes(*snapshot);
+            }
+        }
+        world.destroy();
+    }
+
+    // 手作りのチャンク
+    for (uint32_t seed = 0; seed < 8; seed++) {
+        auto snapshot = std::make_unique<ChunkSnapshot>();
+        fill_mixed(*snapshot, seed);
+        compare_modes(*snapshot);
+    }
+
+    std::printf("%zu chunks: %zu hidden sections, %zu water faces, %zu cactus side faces, %zu merged quads\n",
+                coverage.chunks, coverage.hidden_sections, coverage.water_faces, coverage.cactus_faces,
+                coverage.merged_quads);
+    CHECK(coverage.hidden_sections > 0);
+    CHECK(coverage.water_faces > 0);
+    CHECK(coverage.cactus_faces > 0);
+    CHECK(coverage.merged_quads > 0);
+    return test::finish("test_mesher");
+}
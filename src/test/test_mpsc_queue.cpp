@@ -0,0 +1,108 @@
+// util::MPSCQueue のテスト
+// 複数の生産者と1つの消費者で、全要素が1回ずつ届き、生産者ごとの順序が保たれるかを確かめる。
+// 競合を見るため、ThreadSanitizer 付きでも実行する
+//   (例: g++ -std=c++17 -g -fsanitize=thread test_mpsc_queue.cpp -lpthread)
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "../util/mpsc_queue.hpp"
+#include "test.hpp"
+
+using util::MPSCQueue;
+
+// 生産者の番号と、その生産者の中での通し番号
+struct Item {
+    uint32_t producer = 0;
+    uint32_t index = 0;
+};
+
+static void test_single_thread() {
+    // 容量は 2 のべき乗のみ
+    bool threw = false;
+    try { MPSCQueue<int> bad(6); } catch (const std::invalid_argument&) { threw = true; }
+    CHECK(threw);
+
+    MPSCQueue<int> queue(4);
+    CHECK(queue.capacity() == 4);
+    int out = -1;
+    CHECK(!queue.try_pop(out));
+
+    // 満杯になると try_push は失敗し、1つ取り出すとまた入る
+    for (int i = 0; i < 4; i++) CHECK(queue.try_push(int(i)));
+    CHECK(queue.size_approx() == 4);
+    CHECK(!queue.try_push(99));
+    CHECK(queue.try_pop(out) && out == 0);
+    CHECK(queue.try_push(4));
+    CHECK(!queue.try_push(99));
+
+    // 何周しても FIFO
+    for (int i = 1; i < 1000; i++) {
+        CHECK(queue.try_pop(out) && out == i);
+        CHECK(queue.try_push(i + 4));
+    }
+    for (int i = 1000; i < 1004; i++) CHECK(queue.try_pop(out) && out == i);
+    CHECK(!queue.try_pop(out));
+    CHECK(queue.size_approx() == 0);
+
+    // ムーブで受け渡し、取り出したセルは空にする
+    MPSCQueue<std::unique_ptr<int>> owners(2);
+    CHECK(owners.try_push(std::make_unique<int>(7)));
+    std::unique_ptr<int> got;
+    CHECK(owners.try_pop(got) && got && *got == 7);
+}
+
+// 生産者が満杯で待ちながら押し込み、消費者が並行して取り出す
+static void test_producers(int producers, uint32_t perProducer, size_t capacity) {
+    MPSCQueue<Item> queue(capacity);
+    std::atomic<bool> start{false};
+    std::atomic<uint64_t> fullCount{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            while (!start) std::this_thread::yield();
+            for (uint32_t i = 0; i < perProducer; i++) {
+                while (!queue.try_push(Item{ static_cast<uint32_t>(p), i })) {
+                    fullCount++;
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<uint32_t> next(producers, 0); // 生産者ごとに次に届くはずの通し番号
+    uint64_t received = 0, outOfOrder = 0;
+    const uint64_t total = static_cast<uint64_t>(producers) * perProducer;
+    start = true;
+    Item item;
+    while (received < total) {
+        if (!queue.try_pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item.producer >= static_cast<uint32_t>(producers) || item.index != next[item.producer]) {
+            outOfOrder++;
+        } else {
+            next[item.producer]++;
+        }
+        received++;
+    }
+    for (auto& t : threads) t.join();
+
+    CHECK(outOfOrder == 0);
+    for (int p = 0; p < producers; p++) CHECK(next[p] == perProducer);
+    CHECK(!queue.try_pop(item));
+    std::printf("  %d producers x %u items, capacity %zu: push retried %llu times when full\n",
+                producers, perProducer, capacity, static_cast<unsigned long long>(fullCount.load()));
+}
+
+int main() {
+    test_single_thread();
+    test_producers(1, 100000, 2);
+    test_producers(4, 50000, 16);
+    test_producers(8, 20000, 256);
+    return test::finish("test_mpsc_queue");
+}
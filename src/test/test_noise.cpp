@@ -0,0 +1,88 @@
+// noise.hpp のまとめて計算する版が、どの命令セットでも1点ずつの計算とビット単位で一致するか
+// 最適化やコンパイラの変更で積和が FMA にまとめられると崩れるので、最適化の有無を変えて作る (bin/Makefile)
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "../world/noise.hpp"
+#include "test.hpp"
+
+using namespace ocm;
+
+// World::init と同じ作り方の置換表 (512 要素、後半は前半の複製)
+static std::vector<int> make_perm(unsigned seed) {
+    std::vector<int> p(256);
+    std::iota(p.begin(), p.end(), 0);
+    std::default_random_engine engine(seed);
+    std::shuffle(p.begin(), p.end(), engine);
+    p.insert(p.end(), p.begin(), p.end());
+    return p;
+}
+
+// World::fractal_noise と同じ手順 (3D を y = 0.1 で切る)
+static float fractal_noise_3d(const int* p, float x, float z, int octaves, float persistence, float lacunarity) {
+    float total = 0.0f, frequency = 1.0f, amplitude = 1.0f, maxValue = 0.0f;
+    for (int i = 0; i < octaves; i++) {
+        total += perlin_noise(p, x * frequency, 0.1f, z * frequency) * amplitude;
+        maxValue += amplitude;
+        amplitude *= persistence;
+        frequency *= lacunarity;
+    }
+    return total / maxValue;
+}
+
+static bool same_bits(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+int main() {
+    constexpr size_t N = 100000;
+    const std::vector<int> perm = make_perm(12345);
+    const int* p = perm.data();
+
+    // 地形生成と同じ範囲 (シードのオフセット 0..10000 + ワールド座標 * scale) と、負の座標・整数ちょうどの点
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(-1000.0f, 11000.0f);
+    std::vector<float> x(N), y(N), z(N);
+    for (size_t i = 0; i < N; i++) {
+        x[i] = coord(rng);
+        y[i] = coord(rng);
+        z[i] = coord(rng);
+        if (i % 97 == 0) x[i] = static_cast<float>(static_cast<int>(x[i]));
+    }
+
+    std::vector<float> perlin(N), perlin2d(N), fractal(N), fractal2d(N);
+    for (size_t i = 0; i < N; i++) {
+        perlin[i] = perlin_noise(p, x[i], y[i], z[i]);
+        perlin2d[i] = perlin_noise_2d(p, x[i], z[i]);
+        fractal[i] = fractal_noise_3d(p, x[i], z[i], 5, 0.55f, 2.0f);
+        fractal2d[i] = fractal_noise_2d(p, x[i], z[i], 5, 0.55f, 2.0f);
+    }
+
+    const NoiseIsa best = noise_isa();
+    std::printf("widest ISA on this CPU: %s\n", noise_isa_name(best));
+    for (NoiseIsa isa : { NoiseIsa::SCALAR, NoiseIsa::SSE2, NoiseIsa::AVX2 }) {
+        if (static_cast<int>(isa) > static_cast<int>(best)) {
+            std::printf("  %s: skipped (not supported)\n", noise_isa_name(isa));
+            continue;
+        }
+        // 端数 (4 / 8 点に満たない残り) も通るよう、N は 8 の倍数にしない長さでも試す
+        for (size_t n : { N, N - 5 }) {
+            std::vector<float> out(n);
+            auto prefix = [n](const std::vector<float>& v) { return std::vector<float>(v.begin(), v.begin() + n); };
+
+            perlin_noise_batch(p, x.data(), y.data(), z.data(), out.data(), n, isa);
+            CHECK(same_bits(out, prefix(perlin)));
+            perlin_noise_2d_batch(p, x.data(), z.data(), out.data(), n, isa);
+            CHECK(same_bits(out, prefix(perlin2d)));
+            fractal_noise_batch(p, x.data(), z.data(), out.data(), n, 5, 0.55f, 2.0f, isa);
+            CHECK(same_bits(out, prefix(fractal)));
+            fractal_noise_2d_batch(p, x.data(), z.data(), out.data(), n, 5, 0.55f, 2.0f, isa);
+            CHECK(same_bits(out, prefix(fractal2d)));
+        }
+        std::printf("  %s: checked\n", noise_isa_name(isa));
+    }
+    return test::finish("test_noise");
+}
@@ -0,0 +1,183 @@
+// gfx::OcclusionBuffer のテスト
+// 既知の配置 (遮蔽物の奥・横・手前、近平面にかかる箱)、奇数の幅・高さのミップ、
+// ランダムな配置で「隠れている」と判定した箱が本当に深度バッファの奥にあるか (見える物を消さないか)
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../gfx/occlusion_buffer.hpp"
+#include "test.hpp"
+
+using gfx::AABB;
+using gfx::OcclusionBuffer;
+
+static AABB box(float x0, float y0, float z0, float x1, float y1, float z1) {
+    return { glm::vec3(x0, y0, z0), glm::vec3(x1, y1, z1) };
+}
+
+// 原点から -z を向く、縦 90 度・近 0.1・遠 500 (縦横比はバッファに合わせる)
+static glm::mat4 view_proj(const OcclusionBuffer& buffer) {
+    float aspect = static_cast<float>(buffer.width()) / static_cast<float>(buffer.height());
+    glm::mat4 proj = glm::perspective(1.5707964f, aspect, 0.1f, 500.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    return proj * view;
+}
+
+static void test_known_boxes(int width, int height) {
+    OcclusionBuffer buffer(width, height);
+    const glm::mat4 viewProj = view_proj(buffer);
+
+    // 何も描いていなければ何も隠れない
+    buffer.clear(viewProj);
+    buffer.build_pyramid();
+    CHECK(!buffer.is_occluded(box(-1, -1, -31, 1, 1, -29)));
+
+    // 距離 10 の壁 (x, y: [-5, 5])
+    buffer.clear(viewProj);
+    buffer.draw_occluder(box(-5, -5, -11, 5, 5, -10));
+    buffer.build_pyramid();
+
+    // 壁の奥 (小さい箱と、粗い段で判定される大きい箱)
+    CHECK(buffer.is_occluded(box(-1, -1, -31, 1, 1, -29)));
+    CHECK(buffer.is_occluded(box(-12, -12, -60, 12, 12, -40)));
+    CHECK(buffer.is_occluded(box(-0.1f, -0.1f, -12, 0.1f, 0.1f, -11.5f)));
+    // 壁の横・一部だけ壁からはみ出す・手前・壁と重なる
+    CHECK(!buffer.is_occluded(box(20, -1, -31, 22, 1, -29)));
+    CHECK(!buffer.is_occluded(box(12, -1, -31, 20, 1, -29)));
+    CHECK(!buffer.is_occluded(box(-1, 4, -31, 1, 40, -29)));
+    CHECK(!buffer.is_occluded(box(-1, -1, -6, 1, 1, -5)));
+    CHECK(!buffer.is_occluded(box(-1, -1, -12, 1, 1, -9)));
+    // 背後・画面の外
+    CHECK(!buffer.is_occluded(box(-1, -1, 29, 1, 1, 31)));
+    CHECK(!buffer.is_occluded(box(200, -1, -31, 202, 1, -29)));
+
+    // 近平面にかかる箱は、壁の奥まで伸びていても隠れたことにしない
+    CHECK(!buffer.is_occluded(box(-1, -1, -50, 1, 1, -0.05f)));
+    CHECK(!buffer.is_occluded(box(-1, -1, -50, 1, 1, 1)));
+    CHECK(!buffer.is_occluded(box(-0.01f, -0.01f, -0.09f, 0.01f, 0.01f, -0.05f)));
+
+    // 近平面にかかる遮蔽物 (カメラの後ろまで伸びるもの・カメラと近平面の間で止まるもの) は描かない
+    for (float nearZ : { 1.0f, -0.05f }) {
+        buffer.clear(viewProj);
+        buffer.draw_occluder(box(-5, -5, -11, 5, 5, nearZ));
+        buffer.build_pyramid();
+        CHECK(!buffer.is_occluded(box(-1, -1, -31, 1, 1, -29)));
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) CHECK(buffer.depth(0, x, y) == 1.0f);
+        }
+    }
+}
+
+// 各段の大きさは (下の段 + 1) / 2 で最後は 1x1、各要素は下の段の覆う範囲で最も遠い値以上
+static void test_pyramid(int width, int height) {
+    OcclusionBuffer buffer(width, height);
+    buffer.clear(view_proj(buffer));
+    std::mt19937 rng(static_cast<uint32_t>(width * 1000 + height));
+    std::uniform_real_distribution<float> pos(-20.0f, 20.0f), dist(5.0f, 80.0f), extent(0.5f, 6.0f);
+    for (int i = 0; i < 40; i++) {
+        float x = pos(rng), y = pos(rng), z = -dist(rng);
+        buffer.draw_occluder(box(x, y, z - extent(rng), x + extent(rng), y + extent(rng), z));
+    }
+    buffer.build_pyramid();
+
+    int w = width, h = height;
+    for (int l = 0; l < buffer.level_count(); l++) {
+        if (l > 0) {
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+        }
+        // 最も細かい段の全要素 (奇数の幅・高さの最後の列・行を含む) が上の段で覆われる
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                CHECK(buffer.depth(l, x >> l, y >> l) >= buffer.depth(0, x, y));
+            }
+        }
+        // 各要素は下の段の 2x2 (端では 1x2, 2x1, 1x1) のどれかの値
+        if (l > 0) {
+            int srcW = width, srcH = height;
+            for (int k = 1; k < l; k++) {
+                srcW = (srcW + 1) / 2;
+                srcH = (srcH + 1) / 2;
+            }
+            for (int y = 0; y < h; y++) {
+                for (int x = 0; x < w; x++) {
+                    float d = buffer.depth(l, x, y);
+                    bool found = false;
+                    for (int sy = y * 2; sy <= std::min(y * 2 + 1, srcH - 1); sy++) {
+                        for (int sx = x * 2; sx <= std::min(x * 2 + 1, srcW - 1); sx++) {
+                            found |= buffer.depth(l - 1, sx, sy) == d;
+                        }
+                    }
+                    CHECK(found);
+                }
+            }
+        }
+    }
+    CHECK(w == 1 && h == 1);
+}
+
+// ランダムな遮蔽物と箱で、隠れたと判定した箱の投影範囲の深度が全て箱より手前にあるか
+static void test_conservative(int width, int height) {
+    OcclusionBuffer buffer(width, height);
+    const glm::mat4 viewProj = view_proj(buffer);
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> pos(-30.0f, 30.0f), dist(2.0f, 120.0f), extent(0.2f, 15.0f);
+    auto random_box = [&]() {
+        float x = pos(rng), y = pos(rng), z = -dist(rng);
+        return box(x, y, z - extent(rng), x + extent(rng), y + extent(rng), z);
+    };
+
+    int occluded = 0, tested = 0;
+    for (int frame = 0; frame < 20; frame++) {
+        buffer.clear(viewProj);
+        for (int i = 0; i < 10; i++) buffer.draw_occluder(random_box());
+        buffer.build_pyramid();
+
+        for (int i = 0; i < 200; i++) {
+            AABB b = random_box();
+            tested++;
+            if (!buffer.is_occluded(b)) continue;
+            occluded++;
+
+            // 箱の8頂点の投影範囲 (全て近平面より奥にあるはず)
+            float minX = 1e30f, maxX = -1e30f, minY = 1e30f, maxY = -1e30f, minZ = 1e30f;
+            bool inFront = true;
+            for (int c = 0; c < 8; c++) {
+                glm::vec4 clip = viewProj * glm::vec4((c & 1) ? b.max.x : b.min.x, (c & 2) ? b.max.y : b.min.y,
+                                                      (c & 4) ? b.max.z : b.min.z, 1.0f);
+                inFront &= clip.w > 0.0f && clip.z >= -clip.w;
+                float sx = (clip.x / clip.w * 0.5f + 0.5f) * width;
+                float sy = (clip.y / clip.w * 0.5f + 0.5f) * height;
+                minX = std::min(minX, sx);
+                maxX = std::max(maxX, sx);
+                minY = std::min(minY, sy);
+                maxY = std::max(maxY, sy);
+                minZ = std::min(minZ, clip.z / clip.w);
+            }
+            CHECK(inFront);
+            int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+            int x1 = std::min(width - 1, static_cast<int>(std::floor(maxX)));
+            int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+            int y1 = std::min(height - 1, static_cast<int>(std::floor(maxY)));
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) CHECK(buffer.depth(0, x, y) < minZ);
+            }
+        }
+    }
+    std::printf("  %dx%d: %d/%d random boxes occluded\n", width, height, occluded, tested);
+    CHECK(occluded > 0 && occluded < tested);
+}
+
+int main() {
+    // ゲームと同じ大きさと、幅・高さが奇数の大きさ
+    const int sizes[][2] = { { 256, 144 }, { 37, 23 }, { 64, 33 }, { 1, 1 }, { 5, 2 } };
+    for (const auto& size : sizes) {
+        if (size[0] >= 16 && size[1] >= 16) test_known_boxes(size[0], size[1]);
+        test_pyramid(size[0], size[1]);
+    }
+    test_conservative(256, 144);
+    test_conservative(37, 23);
+    return test::finish("test_occlusion_buffer");
+}
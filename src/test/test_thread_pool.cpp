@@ -0,0 +1,220 @@
+// util::ThreadPool の負荷テスト
+// 投入・盗み・起床・キャンセル・優先度の引き下げ・破棄時の破棄を確かめる。
+// 競合を見るため、ThreadSanitizer / AddressSanitizer 付きでも実行する
+//   (例: g++ -std=c++17 -g -fsanitize=thread test_thread_pool.cpp -lpthread)
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../util/thread_pool.hpp"
+#include "test.hpp"
+
+using util::CancelToken;
+using util::Priority;
+using util::ThreadPool;
+
+// pred が真になるまで待つ (timeout 秒で諦めて false)
+template <class Pred>
+static bool wait_until(Pred pred, double timeout = 10.0) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+// ワーカーを1つ塞ぐタスク (release されるまで戻らない)
+struct Gate {
+    std::atomic<bool> entered{false};
+    std::atomic<bool> released{false};
+    void submit_to(ThreadPool& pool) {
+        pool.submit([this]() {
+            entered = true;
+            while (!released) std::this_thread::yield();
+        });
+        wait_until([this] { return entered.load(); });
+    }
+};
+
+// 複数のスレッドから submit / submit_batch / ワーカー内からの submit を混ぜて投入し、全てがちょうど1回ずつ実行されるか
+static void test_every_task_runs_once() {
+    constexpr int PRODUCERS = 4;
+    constexpr int PER_PRODUCER = 20000;
+    constexpr int TOTAL = PRODUCERS * PER_PRODUCER;
+    std::vector<std::atomic<int>> runs(TOTAL);
+    std::atomic<int> done{0};
+
+    ThreadPool pool(4);
+    auto run = [&](int id) {
+        runs[id].fetch_add(1);
+        done.fetch_add(1);
+    };
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&, p]() {
+            std::mt19937 rng(p);
+            std::vector<ThreadPool::Job> jobs;
+            int id = p * PER_PRODUCER;
+            const int end = id + PER_PRODUCER;
+            while (id < end) {
+                Priority priority = static_cast<Priority>(rng() % 3);
+                switch (rng() % 3) {
+                    case 0:
+                        pool.submit([&run, id]() { run(id); }, priority);
+                        id++;
+                        break;
+                    case 1:
+                        for (int k = 0; k < 64 && id < end; k++, id++) {
+                            jobs.push_back({ [&run, id]() { run(id); }, priority, {} });
+                        }
+                        pool.submit_batch(jobs);
+                        break;
+                    default: {
+                        // ワーカーが自分のキューへ投入する (他のワーカーに盗まれる)
+                        int first = id;
+                        int count = std::min(8, end - id);
+                        pool.submit([&pool, &run, first, count]() {
+                            for (int k = 0; k < count; k++) {
+                                int child = first + k;
+                                pool.submit([&run, child]() { run(child); });
+                            }
+                        }, priority);
+                        id += count;
+                        break;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+
+    CHECK(wait_until([&] { return done.load() == TOTAL; }));
+    int wrong = 0;
+    for (auto& r : runs) wrong += r.load() != 1;
+    CHECK(wrong == 0);
+    CHECK(wait_until([&] { return pool.pending() == 0; }));
+}
+
+// 全員が眠った後の単発の投入で必ず起きるか (起床の取りこぼし)
+static void test_wake_after_sleep() {
+    ThreadPool pool(3);
+    std::atomic<int> done{0};
+    int lost = 0;
+    for (int i = 0; i < 200; i++) {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        pool.submit([&done]() { done.fetch_add(1); });
+        if (!wait_until([&] { return done.load() == i + 1; }, 2.0)) {
+            lost++;
+            break;
+        }
+    }
+    CHECK(lost == 0);
+}
+
+// 未着手のうちにキャンセルしたタスクは実行されずに捨てられる
+static void test_cancel() {
+    ThreadPool pool(1);
+    Gate gate;
+    gate.submit_to(pool);
+
+    constexpr int COUNT = 100;
+    std::vector<CancelToken> tokens;
+    std::vector<std::atomic<int>> runs(COUNT);
+    std::atomic<bool> last{false};
+    for (int i = 0; i < COUNT; i++) {
+        tokens.push_back(CancelToken::create());
+        pool.submit([&runs, i]() { runs[i]++; }, Priority::NORMAL, tokens.back());
+    }
+    pool.submit([&last]() { last = true; });
+    for (int i = 0; i < COUNT; i += 2) tokens[i].cancel();
+    CHECK(pool.pending() == COUNT + 1);
+
+    gate.released = true;
+    CHECK(wait_until([&] { return last.load(); }));
+    for (int i = 0; i < COUNT; i++) {
+        CHECK(runs[i].load() == (i % 2 ? 1 : 0));
+        CHECK(tokens[i].started() == (i % 2 == 1));
+    }
+    CHECK(pool.dropped() == COUNT / 2);
+    CHECK(pool.pending() == 0);
+}
+
+// 優先度の高いクラスから実行し、キュー内で LOW に下げたものは NORMAL より後へ回る
+static void test_priority_demotion() {
+    ThreadPool pool(1);
+    Gate gate;
+    gate.submit_to(pool);
+
+    std::mutex orderMutex;
+    std::vector<int> order;
+    auto record = [&](int id) {
+        return [&order, &orderMutex, id]() {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            order.push_back(id);
+        };
+    };
+
+    // 0..3: HIGH (1 と 3 は後で LOW へ), 10, 11: NORMAL, 20: LOW
+    std::vector<CancelToken> high;
+    pool.submit(record(20), Priority::LOW);
+    pool.submit(record(10), Priority::NORMAL);
+    for (int i = 0; i < 4; i++) {
+        high.push_back(CancelToken::create(Priority::HIGH));
+        pool.submit(record(i), Priority::HIGH, high.back());
+    }
+    pool.submit(record(11), Priority::NORMAL);
+    high[1].set_priority(Priority::LOW);
+    high[3].set_priority(Priority::LOW);
+
+    gate.released = true;
+    CHECK(wait_until([&] {
+        std::lock_guard<std::mutex> lock(orderMutex);
+        return order.size() == 7;
+    }));
+    const std::vector<int> expected = { 0, 2, 10, 11, 20, 1, 3 };
+    CHECK(order == expected);
+}
+
+// 破棄時は実行中のタスクだけを待ち、キューに残ったタスクは実行しない
+static void test_shutdown_drops_queued() {
+    auto pool = std::make_unique<ThreadPool>(1);
+    Gate gate;
+    gate.submit_to(*pool);
+
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 1000; i++) pool->submit([&ran]() { ran++; });
+    std::future<void> future = pool->enqueue([&ran]() { ran++; });
+
+    // 破棄が m_stop を立ててから塞いだタスクを終わらせる
+    std::thread releaser([&gate]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        gate.released = true;
+    });
+    pool.reset();
+    releaser.join();
+
+    CHECK(ran.load() == 0);
+    bool broken = false;
+    try {
+        future.get();
+    } catch (const std::future_error& e) {
+        broken = e.code() == std::future_errc::broken_promise;
+    }
+    CHECK(broken);
+}
+
+int main() {
+    test_every_task_runs_once();
+    test_wake_after_sleep();
+    test_cancel();
+    test_priority_demotion();
+    test_shutdown_drops_queued();
+    return test::finish("test_thread_pool");
+}
@@ -0,0 +1,69 @@
+// pack_vertex -> unpack_vertex の往復が、パックする前の float の頂点 (ChunkVertex) と一致するか
+// 全ての面・lower/inset の組み合わせと、座標・UV・レイヤーの端の値を試す
+#include <cstdio>
+#include "../gfx/vertex.hpp"
+#include "test.hpp"
+
+using namespace gfx;
+
+// パック前のメッシャーが作っていた float の頂点
+//  lower: 水面の上端 (y - 0.1)
+//  inset: サボテンの側面 (FRONT: z-, BACK: z+, RIGHT: x-, LEFT: x+ へ 1/16)
+static ChunkVertex float_vertex(int x, int y, int z, int u, int v, int face, int layer, bool lower, bool inset) {
+    ChunkVertex cv;
+    cv.x = static_cast<float>(x);
+    cv.y = static_cast<float>(y);
+    cv.z = static_cast<float>(z);
+    if (lower) cv.y = cv.y + -0.1f;
+    if (inset) {
+        if (face == 0) cv.z = cv.z - 1.0f / 16.0f;
+        if (face == 1) cv.z = cv.z + 1.0f / 16.0f;
+        if (face == 4) cv.x = cv.x - 1.0f / 16.0f;
+        if (face == 5) cv.x = cv.x + 1.0f / 16.0f;
+    }
+    cv.u = static_cast<float>(u);
+    cv.v = static_cast<float>(v);
+    cv.faceID = static_cast<float>(face);
+    cv.blockID = static_cast<float>(layer);
+    return cv;
+}
+
+static bool same(const ChunkVertex& a, const ChunkVertex& b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z && a.u == b.u && a.v == b.v
+        && a.faceID == b.faceID && a.blockID == b.blockID;
+}
+
+int main() {
+    CHECK(sizeof(PackedVertex) == 8);
+
+    const int xs[] = { 0, 1, 15, 16 };
+    const int ys[] = { 0, 1, 63, 64, 127, 128 };
+    const int uvs[] = { 0, 1, 16, 127, 128 };
+    const int layers[] = { 0, 1, 13, 255 };
+
+    int tested = 0;
+    for (int face = 0; face < 6; face++) {
+        for (int flags = 0; flags < 4; flags++) {
+            bool lower = flags & 1;
+            bool inset = flags & 2;
+            for (int x : xs) for (int y : ys) for (int z : xs) {
+                for (int u : uvs) for (int v : uvs) for (int layer : layers) {
+                    ChunkVertex got = unpack_vertex(pack_vertex(x, y, z, u, v, face, layer, lower, inset));
+                    ChunkVertex want = float_vertex(x, y, z, u, v, face, layer, lower, inset);
+                    if (!same(got, want)) {
+                        std::printf("mismatch: pos (%d, %d, %d) uv (%d, %d) face %d layer %d lower %d inset %d\n",
+                                    x, y, z, u, v, face, layer, lower, inset);
+                        std::printf("  got  (%g, %g, %g) uv (%g, %g) face %g layer %g\n",
+                                    got.x, got.y, got.z, got.u, got.v, got.faceID, got.blockID);
+                        std::printf("  want (%g, %g, %g) uv (%g, %g) face %g layer %g\n",
+                                    want.x, want.y, want.z, want.u, want.v, want.faceID, want.blockID);
+                    }
+                    CHECK(same(got, want));
+                    tested++;
+                }
+            }
+        }
+    }
+    std::printf("%d vertices\n", tested);
+    return test::finish("test_vertex");
+}
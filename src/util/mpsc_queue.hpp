@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+
+namespace util {
+    // 容量固定のロックフリー MPSC キュー (Vyukov の bounded queue を消費者1つに限定したもの)
+    // 各セルの sequence で「書き込み可能 / 読み出し可能」を表し、生産者同士は tail の CAS だけで競合を解決する。
+    // 要素はムーブで出し入れする (T はデフォルト構築とムーブ代入ができること)。
+    // 満杯のときは try_push が false を返すので、生産者側で待つか諦めるかを決める。
+    template<class T>
+    class MPSCQueue {
+        public:
+            // capacity は 2 のべき乗
+            explicit MPSCQueue(size_t capacity)
+                : m_cells(std::make_unique<Cell[]>(capacity)), m_mask(capacity - 1) {
+                if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+                    throw std::invalid_argument("MPSCQueue capacity must be a power of two");
+                }
+                for (size_t i = 0; i < capacity; i++) {
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+            MPSCQueue(const MPSCQueue&) = delete;
+            MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+            // 任意のスレッドから呼べる
+            bool try_push(T&& value) {
+                size_t pos = m_tail.load(std::memory_order_relaxed);
+                for (;;) {
+                    Cell& cell = m_cells[pos & m_mask];
+                    size_t seq = cell.sequence.load(std::memory_order_acquire);
+                    intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                    if (diff == 0) {
+                        if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            cell.value = std::move(value);
+                            cell.sequence.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (diff < 0) {
+                        return false; // 満杯 (消費者がまだ読んでいない)
+                    } else {
+                        pos = m_tail.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // 消費者スレッド (1つ) からのみ呼ぶ
+            bool try_pop(T& out) {
+                Cell& cell = m_cells[m_head & m_mask];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                if (seq != m_head + 1) return false; // 空、または書き込み途中
+                out = std::move(cell.value);
+                cell.value = T();
+                cell.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+                m_head++;
+                return true;
+            }
+
+            size_t capacity() const noexcept { return m_mask + 1; }
+            // おおよその要素数 (消費者スレッドから見た値)
+            size_t size_approx() const noexcept { return m_tail.load(std::memory_order_relaxed) - m_head; }
+
+        private:
+            struct Cell {
+                std::atomic<size_t> sequence{0};
+                T value;
+            };
+
+            std::unique_ptr<Cell[]> m_cells;
+            const size_t m_mask;
+
+            // 生産者と消費者の位置は別のキャッシュラインに置く
+            alignas(64) std::atomic<size_t> m_tail{0};
+            alignas(64) size_t m_head = 0;
+    };
+}
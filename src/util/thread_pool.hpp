@@ -1,66 +1,360 @@
 #pragma once
 
 #include <vector>
-#include <queue>
+#include <deque>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <functional>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <stdexcept>
 #include <future>
 
 namespace util {
+    // ムーブ専用の void() 呼び出し可能オブジェクト
+    // INLINE_SIZE 以下のラムダ等はヒープ確保せずに内部バッファへ格納する (std::function の代わり)
+    class Task {
+        public:
+            static constexpr size_t INLINE_SIZE = 48;
+
+            Task() = default;
+
+            template<class F, class Fn = std::decay_t<F>,
+                     class = std::enable_if_t<!std::is_same<Fn, Task>::value>>
+            Task(F&& f) {
+                if constexpr (fits_inline<Fn>()) {
+                    new (m_storage) Fn(std::forward<F>(f));
+                    m_ops = &inline_ops<Fn>;
+                } else {
+                    *reinterpret_cast<Fn**>(m_storage) = new Fn(std::forward<F>(f));
+                    m_ops = &heap_ops<Fn>;
+                }
+            }
+
+            Task(Task&& other) noexcept { move_from(other); }
+            Task& operator=(Task&& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    move_from(other);
+                }
+                return *this;
+            }
+            Task(const Task&) = delete;
+            Task& operator=(const Task&) = delete;
+            ~Task() { reset(); }
+
+            explicit operator bool() const noexcept { return m_ops != nullptr; }
+            void operator()() { m_ops->invoke(m_storage); }
+
+            void reset() noexcept {
+                if (m_ops) {
+                    m_ops->destroy(m_storage);
+                    m_ops = nullptr;
+                }
+            }
+
+        private:
+            struct Ops {
+                void (*invoke)(void* storage);
+                void (*move)(void* dst, void* src); // src は移動後に破棄まで済ませる
+                void (*destroy)(void* storage);
+            };
+
+            template<class Fn>
+            static constexpr bool fits_inline() {
+                return sizeof(Fn) <= INLINE_SIZE
+                    && alignof(Fn) <= alignof(std::max_align_t)
+                    && std::is_nothrow_move_constructible<Fn>::value;
+            }
+
+            template<class Fn>
+            static constexpr Ops inline_ops = {
+                [](void* s) { (*static_cast<Fn*>(s))(); },
+                [](void* d, void* s) {
+                    new (d) Fn(std::move(*static_cast<Fn*>(s)));
+                    static_cast<Fn*>(s)->~Fn();
+                },
+                [](void* s) { static_cast<Fn*>(s)->~Fn(); },
+            };
+
+            template<class Fn>
+            static constexpr Ops heap_ops = {
+                [](void* s) { (**static_cast<Fn**>(s))(); },
+                [](void* d, void* s) { *static_cast<Fn**>(d) = *static_cast<Fn**>(s); },
+                [](void* s) { delete *static_cast<Fn**>(s); },
+            };
+
+            void move_from(Task& other) noexcept {
+                if (other.m_ops) {
+                    other.m_ops->move(m_storage, other.m_storage);
+                    m_ops = other.m_ops;
+                    other.m_ops = nullptr;
+                }
+            }
+
+            alignas(std::max_align_t) unsigned char m_storage[INLINE_SIZE];
+            const Ops* m_ops = nullptr;
+    };
+
+    // タスクの優先度 (数値が小さいほど先に実行する)
+    enum class Priority : uint8_t {
+        HIGH,
+        NORMAL,
+        LOW,
+        COUNT
+    };
+
+    // 協調的キャンセルと優先度変更のためのトークン
+    // 投入側とタスクで共有し、キャンセルされたタスクはキューから取り出された時点で実行せずに捨てる。
+    // 実行中のタスクは止まらないので、長い処理は cancelled() を見て自分で打ち切る。
+    class CancelToken {
+        public:
+            CancelToken() = default; // 空のトークン (キャンセルも優先度変更もできない)
+
+            static CancelToken create(Priority priority = Priority::NORMAL) {
+                CancelToken token;
+                token.m_state = std::make_shared<State>();
+                token.m_state->priority = static_cast<uint8_t>(priority);
+                return token;
+            }
+
+            explicit operator bool() const noexcept { return m_state != nullptr; }
+            bool operator==(const CancelToken& other) const noexcept { return m_state == other.m_state; }
+            bool operator!=(const CancelToken& other) const noexcept { return m_state != other.m_state; }
+
+            void cancel() const noexcept { if (m_state) m_state->cancelled = true; }
+            bool cancelled() const noexcept { return m_state && m_state->cancelled.load(std::memory_order_relaxed); }
+            // ワーカーが実行を始めたか (始まる前ならキャンセルして投入し直せる)
+            bool started() const noexcept { return m_state && m_state->started.load(std::memory_order_relaxed); }
+
+            // キュー内の優先度を変更する (下げた場合は次に取り出されたときに後ろのクラスへ回す)
+            void set_priority(Priority priority) const noexcept {
+                if (m_state) m_state->priority = static_cast<uint8_t>(priority);
+            }
+            Priority priority() const noexcept {
+                return m_state ? static_cast<Priority>(m_state->priority.load(std::memory_order_relaxed)) : Priority::NORMAL;
+            }
+
+        private:
+            friend class ThreadPool;
+            struct State {
+                std::atomic<bool> cancelled{false};
+                std::atomic<bool> started{false};
+                std::atomic<uint8_t> priority{static_cast<uint8_t>(Priority::NORMAL)};
+            };
+            std::shared_ptr<State> m_state;
+    };
+
+    // ワークスティーリング方式のスレッドプール
+    // ワーカーごとに優先度別の両端キューを持ち、自分のキューは先頭から、空なら他のワーカーの末尾から盗んで実行する。
+    // 外部スレッドからの投入はワーカーのキューへ順番に振り分ける (ワーカー内からの投入は自分のキューへ)。
+    // 破棄時は実行中のタスクだけを待ち、キューに残ったタスクは実行せずに捨てる。
     class ThreadPool {
         public:
-            explicit ThreadPool(size_t threads) : stop(false) {
+            // submit_batch 用
+            struct Job {
+                Task task;
+                Priority priority = Priority::NORMAL;
+                CancelToken token; // 空でもよい
+            };
+
+            explicit ThreadPool(size_t threads) {
+                if (threads == 0) threads = 1;
+                m_queues.reserve(threads);
                 for (size_t i = 0; i < threads; i++) {
-                    workers.emplace_back([this] {
-                        for (;;) {
-                            std::function<void()> task;
-                            {
-                                std::unique_lock<std::mutex> lock(this->queue_mutex);
-                                this->condition.wait(lock, [this] { 
-                                    return this->stop || !this->tasks.empty(); 
-                                });
-
-                                if (this->stop && this->tasks.empty()) 
-                                    return;
-                                task = std::move(this->tasks.front());
-                                this->tasks.pop();
-                            }
-                            task();
-                        }
-                    });
+                    m_queues.emplace_back(std::make_unique<WorkerQueue>());
+                }
+                for (size_t i = 0; i < threads; i++) {
+                    m_workers.emplace_back([this, i] { worker_loop(i); });
                 }
             }
 
+            // 結果を待たない投入 (小さな呼び出し可能オブジェクトならヒープ確保なし)
+            // token を渡した場合、優先度は以後 token の値に従う
+            void submit(Task task, Priority priority = Priority::NORMAL, CancelToken token = {}) {
+                check_running();
+                token.set_priority(priority);
+                // 先に数を増やす (取り出し側の減算が先行しないように)
+                m_pending.fetch_add(1);
+                {
+                    WorkerQueue& queue = *m_queues[pick_queue()];
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    queue.tasks[static_cast<int>(priority)].push_back({ std::move(task), std::move(token) });
+                }
+                wake(1);
+            }
+
+            // まとめて投入 (キューごとのロックと起床通知を1回にまとめる)
+            void submit_batch(std::vector<Job>& jobs) {
+                if (jobs.empty()) return;
+                check_running();
+
+                m_pending.fetch_add(jobs.size());
+                const size_t queueCount = m_queues.size();
+                const size_t first = pick_queue();
+                for (size_t q = 0; q < queueCount && q < jobs.size(); q++) {
+                    WorkerQueue& queue = *m_queues[(first + q) % queueCount];
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    for (size_t i = q; i < jobs.size(); i += queueCount) {
+                        Job& job = jobs[i];
+                        job.token.set_priority(job.priority);
+                        queue.tasks[static_cast<int>(job.priority)].push_back({ std::move(job.task), std::move(job.token) });
+                    }
+                }
+                wake(jobs.size());
+                jobs.clear();
+            }
+
+            // 完了を待つ必要がある場合の投入 (packaged_task を確保する)
+            // 実行前にプールが破棄された場合、future は broken_promise になる
             template<class F>
             auto enqueue(F&& f) -> std::future<void> {
                 auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
-                {
-                    std::unique_lock<std::mutex> lock(queue_mutex);
-                    if (stop) throw std::runtime_error("enqueue on stopped ThreadPool");
-                    tasks.emplace([task](){ (*task)(); });
-                }
-                condition.notify_one();
                 std::future<void> res = task->get_future();
+                submit([task]() { (*task)(); });
                 return res;
             }
 
+            size_t thread_count() const noexcept { return m_workers.size(); }
+            // 投入済みで未着手のタスク数 (キャンセル済みで未回収のものを含む)
+            size_t pending() const noexcept { return m_pending.load(std::memory_order_relaxed); }
+            // キャンセルされて実行せずに捨てたタスク数
+            size_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
             ~ThreadPool() {
                 {
-                    std::unique_lock<std::mutex> lock(queue_mutex);
-                    stop = true;
+                    std::lock_guard<std::mutex> lock(m_sleepMutex);
+                    m_stop = true;
                 }
-                condition.notify_all();
-                for (std::thread &worker : workers) worker.join();
+                m_wake.notify_all();
+                for (std::thread& worker : m_workers) worker.join();
+                // 残ったタスクは m_queues と一緒に破棄される
             }
-        
+
         private:
-            std::vector<std::thread> workers;
-            std::queue<std::function<void()>> tasks;
+            struct Entry {
+                Task task;
+                CancelToken token;
+            };
+            static constexpr int PRIORITY_COUNT = static_cast<int>(Priority::COUNT);
+
+            struct WorkerQueue {
+                std::mutex mutex;
+                std::deque<Entry> tasks[PRIORITY_COUNT];
+            };
+
+            std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+            std::vector<std::thread> m_workers;
+
+            std::atomic<size_t> m_pending{0};  // 全キューのタスク数
+            std::atomic<size_t> m_sleeping{0}; // 待機中のワーカー数
+            std::atomic<size_t> m_nextQueue{0};
+            std::atomic<size_t> m_dropped{0};
+            std::atomic<bool> m_stop{false};
+
+            std::mutex m_sleepMutex;
+            std::condition_variable m_wake;
+
+            // 実行中のワーカーが属するプールとその番号
+            static inline thread_local ThreadPool* t_pool = nullptr;
+            static inline thread_local size_t t_index = 0;
+
+            // 停止後の投入は例外 (停止中も実行中のタスクからの投入は受け付け、そのまま捨てる)
+            void check_running() const {
+                if (m_stop.load(std::memory_order_relaxed) && t_pool != this) {
+                    throw std::runtime_error("submit on stopped ThreadPool");
+                }
+            }
+
+            size_t pick_queue() {
+                if (t_pool == this) return t_index;
+                return m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+            }
+
+            void wake(size_t count) {
+                // m_pending の増加と m_sleeping の読み取りはどちらも seq_cst なので、
+                // 待機に入るワーカーは必ずどちらかで気づく
+                if (m_sleeping.load() == 0) return;
+                { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+                if (count == 1) m_wake.notify_one();
+                else m_wake.notify_all();
+            }
 
-            std::mutex queue_mutex;
-            std::condition_variable condition;
-            bool stop;
+            // 優先度の高いクラスから1つ取り出す (front: 自分のキュー, back: 盗む側)
+            // キャンセル済みは捨て、優先度が下げられたものは該当するクラスの末尾へ回す
+            bool take(WorkerQueue& queue, bool front, Task& out) {
+                for (int p = 0; p < PRIORITY_COUNT; p++) {
+                    std::deque<Entry>& tasks = queue.tasks[p];
+                    while (!tasks.empty()) {
+                        Entry entry = std::move(front ? tasks.front() : tasks.back());
+                        if (front) tasks.pop_front();
+                        else tasks.pop_back();
+
+                        if (entry.token.cancelled()) {
+                            m_pending.fetch_sub(1);
+                            m_dropped.fetch_add(1, std::memory_order_relaxed);
+                            continue;
+                        }
+                        int current = static_cast<int>(entry.token.priority());
+                        if (entry.token && current > p) {
+                            queue.tasks[current].push_back(std::move(entry));
+                            continue;
+                        }
+
+                        if (entry.token) entry.token.m_state->started = true;
+                        m_pending.fetch_sub(1);
+                        out = std::move(entry.task);
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            bool pop_own(size_t index, Task& out) {
+                WorkerQueue& queue = *m_queues[index];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                return take(queue, true, out);
+            }
+
+            bool steal(size_t index, Task& out) {
+                for (size_t k = 1; k < m_queues.size(); k++) {
+                    WorkerQueue& queue = *m_queues[(index + k) % m_queues.size()];
+                    std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+                    if (!lock.owns_lock()) continue;
+                    if (take(queue, false, out)) return true;
+                }
+                return false;
+            }
+
+            void worker_loop(size_t index) {
+                t_pool = this;
+                t_index = index;
+
+                Task task;
+                for (;;) {
+                    if (m_stop.load(std::memory_order_relaxed)) return;
+
+                    if (pop_own(index, task) || steal(index, task)) {
+                        task();
+                        task.reset();
+                        continue;
+                    }
+
+                    // try_lock で取り逃したタスクがあれば、眠らずにもう一度探す
+                    if (m_pending.load() > 0) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(m_sleepMutex);
+                    m_sleeping.fetch_add(1);
+                    m_wake.wait(lock, [this] { return m_stop || m_pending.load() > 0; });
+                    m_sleeping.fetch_sub(1);
+                }
+            }
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,133 @@
+#include "block_storage.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace ocm {
+    BlockStorage::BlockStorage(int volume, uint8_t fill) : m_volume(volume) {
+        // 初期状態は fill のみのパレット (配列なし)
+        m_palette.push_back(fill);
+    }
+
+    int BlockStorage::bits_for_palette(size_t count) {
+        if (count <= 1) return 0;
+        if (count <= 2) return 1;
+        if (count <= 4) return 2;
+        if (count <= 16) return 4;
+        return 8;
+    }
+
+    int BlockStorage::palette_index(uint8_t id) const {
+        for (size_t i = 0; i < m_palette.size(); i++) {
+            if (m_palette[i] == id) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    uint32_t BlockStorage::raw_get(int index) const {
+        if (m_bits == 0) return 0;
+        uint64_t word = m_data[static_cast<size_t>(index) >> m_perWordShift];
+        int shift = (index & m_perWordMask) * m_bits;
+        return static_cast<uint32_t>((word >> shift) & m_valueMask);
+    }
+
+    void BlockStorage::raw_set(int index, uint32_t value) {
+        uint64_t& word = m_data[static_cast<size_t>(index) >> m_perWordShift];
+        int shift = (index & m_perWordMask) * m_bits;
+        word = (word & ~(m_valueMask << shift)) | (static_cast<uint64_t>(value) << shift);
+    }
+
+    // ビット幅を変更して既存データを詰め直す
+    void BlockStorage::resize_bits(int bits) {
+        std::vector<uint32_t> old;
+        if (m_bits != 0) {
+            old.resize(m_volume);
+            for (int i = 0; i < m_volume; i++) old[i] = raw_get(i);
+        }
+
+        m_bits = bits;
+        if (bits == 0) {
+            // uniform: インデックスは常に 0
+            std::vector<uint64_t>().swap(m_data);
+            m_perWordShift = m_perWordMask = 0;
+            m_valueMask = 0;
+            return;
+        }
+
+        // uniform から広げる場合、old は空で全要素がインデックス 0 のまま
+        int perWord = 64 / bits;
+        m_perWordShift = 0;
+        while ((1 << m_perWordShift) < perWord) m_perWordShift++;
+        m_perWordMask = perWord - 1;
+        m_valueMask = (1ULL << bits) - 1;
+
+        std::vector<uint64_t>((m_volume + perWord - 1) / perWord, 0).swap(m_data);
+        for (size_t i = 0; i < old.size(); i++) raw_set(static_cast<int>(i), old[i]);
+    }
+
+    bool BlockStorage::set(int index, uint8_t id) {
+        if (m_bits == 0 && m_palette[0] == id) return false;
+
+        int pi = palette_index(id);
+        if (pi < 0) {
+            // 新しいIDはパレットに追加し、収まらなければビット幅を広げる
+            m_palette.push_back(id);
+            pi = static_cast<int>(m_palette.size() - 1);
+            int bits = bits_for_palette(m_palette.size());
+            if (bits != m_bits) resize_bits(bits);
+        }
+
+        if (raw_get(index) == static_cast<uint32_t>(pi)) return false;
+        raw_set(index, static_cast<uint32_t>(pi));
+        return true;
+    }
+
+    void BlockStorage::decode(uint8_t* out) const {
+        if (m_bits == 0) {
+            std::memset(out, m_palette[0], m_volume);
+            return;
+        }
+
+        const int perWord = m_perWordMask + 1;
+        const uint8_t* palette = m_palette.data();
+        int i = 0;
+        for (uint64_t word : m_data) {
+            int n = std::min(perWord, m_volume - i);
+            for (int k = 0; k < n; k++) {
+                out[i++] = palette[word & m_valueMask];
+                word >>= m_bits;
+            }
+        }
+    }
+
+    void BlockStorage::compact() {
+        if (m_bits == 0) return;
+
+        std::vector<uint32_t> count(m_palette.size(), 0);
+        for (int i = 0; i < m_volume; i++) count[raw_get(i)]++;
+
+        // 使用中のエントリだけで新しいパレットを作る
+        std::vector<uint8_t> palette;
+        std::vector<uint32_t> remap(m_palette.size(), 0);
+        for (size_t i = 0; i < m_palette.size(); i++) {
+            if (count[i] == 0) continue;
+            remap[i] = static_cast<uint32_t>(palette.size());
+            palette.push_back(m_palette[i]);
+        }
+        if (palette.empty()) palette.push_back(0);
+        if (palette.size() == m_palette.size()) return;
+
+        std::vector<uint32_t> indices(m_volume);
+        for (int i = 0; i < m_volume; i++) indices[i] = remap[raw_get(i)];
+
+        m_palette = std::move(palette);
+        m_palette.shrink_to_fit();
+        m_bits = 0; // 詰め直すので既存データは捨てる
+        resize_bits(bits_for_palette(m_palette.size()));
+        if (m_bits == 0) return;
+        for (int i = 0; i < m_volume; i++) raw_set(i, indices[i]);
+    }
+
+    size_t BlockStorage::memory_bytes() const {
+        return sizeof(*this) + m_palette.capacity() + m_data.capacity() * sizeof(uint64_t);
+    }
+} // namespace ocm
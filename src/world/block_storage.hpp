@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace ocm {
+    // パレット圧縮されたブロック配列
+    // ブロックIDをパレットのインデックスに置き換え、1/2/4/8 bit に詰めて保持する。
+    // 1ワード (64bit) に収まる要素数が 2 の累乗になるので、要素がワードをまたぐことはない。
+    // 全要素が同じブロックの場合は 0 bit (パレットの1要素のみ、配列は確保しない) になる。
+    class BlockStorage {
+        public:
+            explicit BlockStorage(int volume, uint8_t fill = 0);
+
+            int volume() const noexcept { return m_volume; }
+            int bits_per_block() const noexcept { return m_bits; }
+            const std::vector<uint8_t>& palette() const noexcept { return m_palette; }
+
+            // 単一ブロックで埋まっているか (0 bit 表現)
+            bool is_uniform() const noexcept { return m_bits == 0; }
+            uint8_t uniform_value() const noexcept { return m_palette[0]; }
+
+            uint8_t get(int index) const {
+                if (m_bits == 0) return m_palette[0];
+                uint64_t word = m_data[static_cast<size_t>(index) >> m_perWordShift];
+                int shift = (index & m_perWordMask) * m_bits;
+                return m_palette[(word >> shift) & m_valueMask];
+            }
+
+            // 値が変わった場合のみ true を返す
+            bool set(int index, uint8_t id);
+
+            // 全要素をブロックIDとして展開 (out には volume() 個分の領域が必要)
+            void decode(uint8_t* out) const;
+
+            // 使われていないパレットエントリを取り除き、必要最小のビット幅で詰め直す
+            // 1種類しか残らなければ 0 bit に落とす
+            void compact();
+
+            size_t memory_bytes() const;
+
+        private:
+            int m_volume;
+            int m_bits = 0;         // 0 = uniform
+            int m_perWordShift = 0; // log2(64 / bits)
+            int m_perWordMask = 0;  // (64 / bits) - 1
+            uint64_t m_valueMask = 0;
+
+            std::vector<uint8_t> m_palette;
+            std::vector<uint64_t> m_data;
+
+            int palette_index(uint8_t id) const;
+            void resize_bits(int bits);
+            uint32_t raw_get(int index) const;
+            void raw_set(int index, uint32_t value);
+
+            static int bits_for_palette(size_t count);
+    };
+} // namespace ocm
@@ -1,161 +1,144 @@
 #include "chunk.hpp"
 #include "../gfx/vertex.hpp"
 #include "../block/block.hpp"
+#include "section_visibility.hpp"
 #include <cstring>
 #include <algorithm>
 #include <GLFW/glfw3.h>
 
 namespace ocm {
     Chunk::Chunk(int cx, int cz)
-        : m_cx(cx), m_cz(cz), is_dirty(true), is_meshing(false),
-          vao(0), vbo(0), ebo(0), indexCount(0),
-          trans_vao(0), trans_vbo(0), trans_ebo(0), trans_indexCount(0) {
-        // ブロックデータを空気(0)で初期化
-        std::memset(m_blocks, 0, sizeof(m_blocks));
+        : m_cx(cx), m_cz(cz) {
+        // ブロックデータは空気(0)で初期化される (配列は確保しない)
+        m_sections.reserve(SECTION_COUNT);
+        for (int sy = 0; sy < SECTION_COUNT; sy++) {
+            m_sections.emplace_back(SECTION_VOLUME);
+        }
+        section_connectivity.fill(ALL_FACES_CONNECTED);
     }
     
-    Chunk::~Chunk() {
-        if (vao != 0) {
-            glDeleteVertexArrays(1, &vao);
-            glDeleteBuffers(1, &vbo);
-            glDeleteBuffers(1, &ebo);
-        }
-        if (trans_vao != 0) {
-            glDeleteVertexArrays(1, &trans_vao);
-            glDeleteBuffers(1, &trans_vbo);
-            glDeleteBuffers(1, &trans_ebo);
-        }
-    };
+    Chunk::~Chunk() = default;
 
     uint8_t Chunk::get_block(int x, int y, int z) const {
         if (x < 0 || x >= CHUNK_SIZE_X || y < 0 || y >= CHUNK_SIZE_Y || z < 0 || z >= CHUNK_SIZE_Z) return 0; // AIR
-        return m_blocks[get_index(x, y, z)];
+        return m_sections[y / SECTION_SIZE].get(get_index(x, y % SECTION_SIZE, z));
     }
     
     void Chunk::set_block(int x, int y, int z, uint8_t id) {
         if (x < 0 || x >= CHUNK_SIZE_X || y < 0 || y >= CHUNK_SIZE_Y || z < 0 || z >= CHUNK_SIZE_Z) return;
 
-        int idx = get_index(x, y, z);
-        if (m_blocks[idx] != id) {
-            m_blocks[idx] = id;
+        if (m_sections[y / SECTION_SIZE].set(get_index(x, y % SECTION_SIZE, z), id)) {
             is_dirty = true;
+            version++;
         }
     }
 
-    void Chunk::add_face(
-        std::vector<gfx::ChunkVertex>& vertices, 
-        std::vector<uint32_t>& indices, 
-        int x, int y, int z, 
-        FaceDirection dir, 
-        uint32_t& vertex_offset,
-        uint8_t blockID
-    ) {
-        float fx = static_cast<float>(x);
-        float fy = static_cast<float>(y);
-        float fz = static_cast<float>(z);
-
-        // 水面を下げる
-        float yoffset = 0.0f;
-        if (blockID == static_cast<uint8_t>(BlockID::WATER)) {
-            yoffset = -0.1f;
-        }
-        
-        float inset = 0.0f;
-        if (blockID == static_cast<uint8_t>(BlockID::CACTUS)) {
-            // inset = 0.1f;
-            inset = 1.0f / 16.0f; // 1/16
+    void Chunk::decode_blocks(uint8_t* out) const {
+        for (int sy = 0; sy < SECTION_COUNT; sy++) {
+            m_sections[sy].decode(out + sy * SECTION_VOLUME);
         }
+    }
 
-        // Determine the faceID
-        float fID = static_cast<float>(dir);
-        
-        float textureLayer = 0.0f;
-        if (blockID == 1) { // DIRT
-            textureLayer = 1.0f;
-        } else if (blockID == 2) { 
-            // GRASS_BLOCK
-            if (dir == TOP) textureLayer = 2.0f;
-            else if (dir == BOTTOM) textureLayer = 1.0f;
-            else textureLayer = 3.0f;
+    bool Chunk::section_uniform(int sy, uint8_t* id) const {
+        const BlockStorage& section = m_sections[sy];
+        if (!section.is_uniform()) return false;
+        if (id) *id = section.uniform_value();
+        return true;
+    }
 
-        } else if (blockID == 3) { // SAND
-            textureLayer = 4.0f;
-        } else if (blockID == 4) { // STONE
-            textureLayer = 5.0f;
-        } else if (blockID == 5) { // COBBLESTONE
-            textureLayer = 6.0f;
-        } else if (blockID == 6) { // WATER
-            textureLayer = 7.0f;
-        } else if (blockID == 7) { 
-            // OAK_LOG
-            if (dir == TOP || dir == BOTTOM) textureLayer = 9.0f;
-            else textureLayer = 8.0f;
+    void Chunk::compact() {
+        for (auto& section : m_sections) section.compact();
+    }
 
-        } else if (blockID == 8) { // OAK_LEAVES
-            textureLayer = 10.0f;
-        } else if (blockID == 9) { 
-            // CACTUS
-            if (dir == TOP) textureLayer = 13.0f;
-            else if (dir == BOTTOM) textureLayer = 11.0f;
-            else textureLayer = 12.0f;
+    size_t Chunk::memory_bytes() const {
+        size_t bytes = sizeof(*this);
+        for (const auto& section : m_sections) bytes += section.memory_bytes();
+        return bytes;
+    }
 
-        } else {
-            textureLayer = 0.0f; // Placeholder
+    uint64_t Chunk::content_hash() const {
+        uint64_t hash = 14695981039346656037ull;
+        uint8_t blocks[SECTION_VOLUME];
+        for (const auto& section : m_sections) {
+            section.decode(blocks);
+            for (uint8_t id : blocks) {
+                hash ^= id;
+                hash *= 1099511628211ull;
+            }
         }
+        return hash;
+    }
+
+    void Chunk::add_face(
+        std::vector<gfx::PackedVertex>& vertices, 
+        int x, int y, int z, 
+        FaceDirection dir, 
+        uint8_t blockID
+    ) {
+        add_quad(vertices, x, y, z, dir, 1, 1, blockID);
+    }
+
+    void Chunk::add_quad(
+        std::vector<gfx::PackedVertex>& vertices, 
+        int x, int y, int z, 
+        FaceDirection dir, 
+        int w, int h,
+        uint8_t blockID
+    ) {
+        // テクスチャ層・水面の下げ・サボテンの寄せはブロックの性質表から
+        const BlockInfo& info = block_info(blockID);
+        int textureLayer = info.layers[dir];
+        bool lower = info.lowered;
+        bool inset = info.inset && dir != TOP && dir != BOTTOM;
+
+        // 頂点は格子点の整数座標でパックする (top: 上端の頂点。lower のとき下げる)
+        // 結合した面の大きさ w, h はそのまま UV にしてテクスチャを繰り返す
+        auto push = [&](int px, int py, int pz, int u, int v, bool top) {
+            vertices.push_back(gfx::pack_vertex(px, py, pz, u, v, dir, textureLayer, lower && top, inset));
+        };
 
         // Define the 4 vertices for each face based on direction
         switch (dir) {
-            case TOP: // Y+
-                vertices.push_back({fx,   fy+1+yoffset, fz+1, 0, 0, fID, textureLayer});
-                vertices.push_back({fx+1, fy+1+yoffset, fz+1, 1, 0, fID, textureLayer});
-                vertices.push_back({fx+1, fy+1+yoffset, fz,   1, 1, fID, textureLayer});
-                vertices.push_back({fx,   fy+1+yoffset, fz,   0, 1, fID, textureLayer});
+            case TOP: // Y+ (w: x方向, h: z方向)
+                push(x,     y+1, z+h, 0, 0, true);
+                push(x+w,   y+1, z+h, w, 0, true);
+                push(x+w,   y+1, z,   w, h, true);
+                push(x,     y+1, z,   0, h, true);
                 break;
-            case BOTTOM: // Y-
-                vertices.push_back({fx,   fy, fz,   0, 0, fID, textureLayer});
-                vertices.push_back({fx+1, fy, fz,   1, 0, fID, textureLayer});
-                vertices.push_back({fx+1, fy, fz+1, 1, 1, fID, textureLayer});
-                vertices.push_back({fx,   fy, fz+1, 0, 1, fID, textureLayer});
+            case BOTTOM: // Y- (w: x方向, h: z方向)
+                push(x,     y, z,     0, 0, false);
+                push(x+w,   y, z,     w, 0, false);
+                push(x+w,   y, z+h,   w, h, false);
+                push(x,     y, z+h,   0, h, false);
                 break;
 
-            case SIDE_FRONT: // Z+
-                vertices.push_back({fx,   fy,   fz+1-inset, 0, 1, fID, textureLayer});
-                vertices.push_back({fx+1, fy,   fz+1-inset, 1, 1, fID, textureLayer});
-                vertices.push_back({fx+1, fy+1+yoffset, fz+1-inset, 1, 0, fID, textureLayer});
-                vertices.push_back({fx,   fy+1+yoffset, fz+1-inset, 0, 0, fID, textureLayer});
+            case SIDE_FRONT: // Z+ (w: x方向, h: y方向)
+                push(x,     y,   z+1, 0, h, false);
+                push(x+w,   y,   z+1, w, h, false);
+                push(x+w,   y+h, z+1, w, 0, true);
+                push(x,     y+h, z+1, 0, 0, true);
                 break;
                 
-            case SIDE_BACK: // Z-
-                vertices.push_back({fx+1, fy,   fz+inset,   0, 1, fID, textureLayer});
-                vertices.push_back({fx,   fy,   fz+inset,   1, 1, fID, textureLayer});
-                vertices.push_back({fx,   fy+1+yoffset, fz+inset,   1, 0, fID, textureLayer});
-                vertices.push_back({fx+1, fy+1+yoffset, fz+inset,   0, 0, fID, textureLayer});
+            case SIDE_BACK: // Z- (w: x方向, h: y方向)
+                push(x+w,   y,   z,   0, h, false);
+                push(x,     y,   z,   w, h, false);
+                push(x,     y+h, z,   w, 0, true);
+                push(x+w,   y+h, z,   0, 0, true);
                 break;
 
-            case SIDE_RIGHT: // X+
-                vertices.push_back({fx+1-inset, fy,   fz+1, 0, 1, fID, textureLayer});
-                vertices.push_back({fx+1-inset, fy,   fz,   1, 1, fID, textureLayer});
-                vertices.push_back({fx+1-inset, fy+1+yoffset, fz,   1, 0, fID, textureLayer});
-                vertices.push_back({fx+1-inset, fy+1+yoffset, fz+1, 0, 0, fID, textureLayer});
+            case SIDE_RIGHT: // X+ (w: z方向, h: y方向)
+                push(x+1,   y,   z+w, 0, h, false);
+                push(x+1,   y,   z,   w, h, false);
+                push(x+1,   y+h, z,   w, 0, true);
+                push(x+1,   y+h, z+w, 0, 0, true);
                 break;
 
-            case SIDE_LEFT: // X-
-                vertices.push_back({fx+inset,   fy,   fz,   0, 1, fID, textureLayer});
-                vertices.push_back({fx+inset,   fy,   fz+1, 1, 1, fID, textureLayer});
-                vertices.push_back({fx+inset,   fy+1+yoffset, fz+1, 1, 0, fID, textureLayer});
-                vertices.push_back({fx+inset,   fy+1+yoffset, fz,   0, 0, fID, textureLayer});
+            case SIDE_LEFT: // X- (w: z方向, h: y方向)
+                push(x,     y,   z,   0, h, false);
+                push(x,     y,   z+w, w, h, false);
+                push(x,     y+h, z+w, w, 0, true);
+                push(x,     y+h, z,   0, 0, true);
                 break;
         }
-
-        // Add indexes
-        indices.push_back(vertex_offset + 0);
-        indices.push_back(vertex_offset + 1);
-        indices.push_back(vertex_offset + 2);
-
-        indices.push_back(vertex_offset + 2);
-        indices.push_back(vertex_offset + 3);
-        indices.push_back(vertex_offset + 0);
-
-        vertex_offset += 4;
     }
 } // namespace ocm
\ No newline at end of file
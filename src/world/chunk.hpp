@@ -1,11 +1,14 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <vector>
 #include <memory>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "../gfx/vertex.hpp"
+#include "../gfx/buffer_arena.hpp"
+#include "block_storage.hpp"
 
 namespace ocm {
     enum FaceDirection {
@@ -20,21 +23,55 @@ namespace ocm {
     constexpr int CHUNK_SIZE_X = 16;
     constexpr int CHUNK_SIZE_Y = 128;
     constexpr int CHUNK_SIZE_Z = 16;
+
+    // 縦方向を 16x16x16 のセクションに分割して保持する
+    constexpr int SECTION_SIZE = 16;
+    constexpr int SECTION_COUNT = CHUNK_SIZE_Y / SECTION_SIZE;
+    constexpr int SECTION_VOLUME = CHUNK_SIZE_X * SECTION_SIZE * CHUNK_SIZE_Z;
+
     class Chunk {
         public:
             Chunk(int cx, int cz);
             ~Chunk();
 
-            // OpenGLのリソースID
-            uint32_t vao = 0, vbo = 0, ebo = 0;
+            // メッシュは CubeRenderer の共有頂点バッファ内の区間 (解放は CubeRenderer::release_chunk_mesh)
+            // インデックスも共有バッファ (index_type はその型)
+            gfx::BufferArena::Handle mesh = gfx::BufferArena::INVALID;
             int indexCount = 0;
+            GLenum index_type = GL_UNSIGNED_SHORT;
 
-            uint32_t trans_vao = 0, trans_vbo = 0, trans_ebo = 0;
+            gfx::BufferArena::Handle trans_mesh = gfx::BufferArena::INVALID;
             int trans_indexCount = 0;
+            GLenum trans_index_type = GL_UNSIGNED_SHORT;
+
+            // メッシュ内のセクションごとの区間 (四角形単位、gfx::MeshData::opaque_sections と同じ形)
+            // セクション単位で視錐台カリングして、見えるところだけ描画する
+            std::array<uint32_t, SECTION_COUNT + 1> section_quads{};
+            std::array<uint32_t, SECTION_COUNT + 1> trans_section_quads{};
+            // 四角形を1つ以上持つセクション (bit s)
+            uint8_t mesh_sections = 0;
+            // セクションごとの面のつながり (ocm::FaceConnectivity、メッシュ構築時に求める)
+            // 未構築の間は全ての面がつながっているものとして扱う
+            std::array<uint64_t, SECTION_COUNT> section_connectivity;
+            // 区画 (8x8 列) ごとの、下から途切れずに不透明な高さ (CPU の遮蔽物の箱、0 なら箱なし)
+            std::array<uint8_t, 4> solid_heights{};
+
+            // GPU に確保したメッシュのバイト数 (常駐メモリの集計用)
+            size_t gpu_bytes = 0;
+
+            // 最後に描画対象になったフレーム (アンロード順の判定用)
+            uint64_t last_visible_frame = 0;
  
             // メッシュの再構築が必要か
             bool is_dirty = true;
-            void set_dirty(bool dirty) { is_dirty = dirty; }
+            void set_dirty(bool dirty) {
+                is_dirty = dirty;
+                if (dirty) version++;
+            }
+
+            // 変更のたびに増えるカウンタ (ブロックの変更と set_dirty(true))
+            // メッシュ依頼時の値より新しくなっていれば、その結果は古いので捨てる
+            uint32_t version = 0;
             
             // スレッドプールでメッシュ計算中か
             bool is_meshing = false;
@@ -47,25 +84,47 @@ namespace ocm {
             uint8_t get_block(int x, int y, int z) const;
             void set_block(int x, int y, int z, uint8_t id);
 
-            // 面を追加するヘルパー関数
+            // 全ブロックを get_index の順で一括展開 (メッシュ構築用)
+            void decode_blocks(uint8_t* out) const;
+            // セクション sy を展開 (out には SECTION_VOLUME 個分、y-z-x 順)
+            void decode_section(int sy, uint8_t* out) const { m_sections[sy].decode(out); }
+            // セクションが単一ブロックで埋まっているか (id にそのブロックを返す)
+            bool section_uniform(int sy, uint8_t* id = nullptr) const;
+
+            // 生成完了後にパレットを詰め直す (単一ブロックのセクションは配列を解放)
+            void compact();
+            size_t memory_bytes() const;
+            // 全ブロック (get_index の順) の FNV-1a 64bit ハッシュ (パレットの詰め方によらず中身だけで決まる)
+            uint64_t content_hash() const;
+
+            // 面を追加するヘルパー関数 (インデックスは 0,1,2,2,3,0 の固定パターンなので出力しない)
             static void add_face(
-                std::vector<gfx::ChunkVertex>& vertices, 
-                std::vector<uint32_t>& indices, 
+                std::vector<gfx::PackedVertex>& vertices, 
                 int x, int y, int z, 
                 FaceDirection dir, 
-                uint32_t& vertex_offset,
+                uint8_t blockID
+            );
+            // w x h ブロック分に結合した面を追加する (軸の対応は chunk.cpp を参照)
+            static void add_quad(
+                std::vector<gfx::PackedVertex>& vertices, 
+                int x, int y, int z, 
+                FaceDirection dir, 
+                int w, int h,
                 uint8_t blockID
             );
     
         private:
             int m_cx, m_cz;
-            // メモリ効率のため1次元配列
-            uint8_t m_blocks[CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z];
-    
+            // セクションごとにパレット圧縮した配列
+            std::vector<BlockStorage> m_sections;
+
+        public:
+            static constexpr int VOLUME = CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z;
+
             // インデックス計算用のヘルパー
-            inline int get_index(int x, int y, int z) const {
-                // return x + CHUNK_SIZE_X * (z + CHUNK_SIZE_Z * y);
-                return x + (y * CHUNK_SIZE_X) + (z * CHUNK_SIZE_X * CHUNK_SIZE_Y);
+            // y を最上位にすることで、各セクションが連続した SECTION_VOLUME 個の範囲になる
+            static inline int get_index(int x, int y, int z) {
+                return x + (z * CHUNK_SIZE_X) + (y * CHUNK_SIZE_X * CHUNK_SIZE_Z);
             }
     };
     
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include "chunk.hpp"
+
+namespace ocm {
+    // チャンク座標 (cx, cz) -> ChunkPtr のオープンアドレス法ハッシュテーブル
+    // - キーは 64bit にパックした (cx, cz)
+    // - スロット配列は線形探査、削除は後方シフト (トゥームストーンなし)
+    // - 実体は密な配列に格納し、イテレーションはその配列を順に走査する
+    //   (再ハッシュでは順序が変わらない。erase のみ末尾要素が空いた位置へ移動する)
+    class ChunkMap {
+        public:
+            struct Entry {
+                uint64_t key;
+                ChunkPtr chunk;
+
+                int cx() const { return unpack_x(key); }
+                int cz() const { return unpack_z(key); }
+            };
+
+            static constexpr uint64_t pack_key(int cx, int cz) {
+                return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cz);
+            }
+            static constexpr int unpack_x(uint64_t key) { return static_cast<int32_t>(static_cast<uint32_t>(key >> 32)); }
+            static constexpr int unpack_z(uint64_t key) { return static_cast<int32_t>(static_cast<uint32_t>(key)); }
+
+            ChunkMap() = default;
+            ChunkMap(const ChunkMap&) = delete;
+            ChunkMap& operator=(const ChunkMap&) = delete;
+
+            size_t size() const noexcept { return m_entries.size(); }
+            bool empty() const noexcept { return m_entries.empty(); }
+
+            void clear() {
+                m_entries.clear();
+                m_slots.clear();
+                m_mask = 0;
+            }
+
+            void reserve(size_t count) {
+                m_entries.reserve(count);
+                size_t cap = 16;
+                while (cap * MAX_LOAD_NUM < count * MAX_LOAD_DEN) cap <<= 1;
+                if (cap > m_slots.size()) rehash(cap);
+            }
+
+            Chunk* find(int cx, int cz) const {
+                if (m_entries.empty()) return nullptr;
+                const uint64_t key = pack_key(cx, cz);
+                for (size_t i = hash(key) & m_mask;; i = (i + 1) & m_mask) {
+                    const Slot& s = m_slots[i];
+                    if (s.index == EMPTY) return nullptr;
+                    if (s.key == key) return m_entries[s.index].chunk.get();
+                }
+            }
+
+            bool contains(int cx, int cz) const { return find(cx, cz) != nullptr; }
+
+            // 既存のエントリがあれば置き換える
+            Chunk* insert_or_assign(int cx, int cz, ChunkPtr chunk) {
+                if ((m_entries.size() + 1) * MAX_LOAD_DEN > m_slots.size() * MAX_LOAD_NUM) {
+                    rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+                }
+
+                const uint64_t key = pack_key(cx, cz);
+                size_t i = hash(key) & m_mask;
+                for (;; i = (i + 1) & m_mask) {
+                    Slot& s = m_slots[i];
+                    if (s.index == EMPTY) break;
+                    if (s.key == key) {
+                        m_entries[s.index].chunk = std::move(chunk);
+                        return m_entries[s.index].chunk.get();
+                    }
+                }
+
+                m_slots[i] = { key, static_cast<uint32_t>(m_entries.size()) };
+                m_entries.push_back({ key, std::move(chunk) });
+                return m_entries.back().chunk.get();
+            }
+
+            // 取り除いたチャンクを返す (存在しなければ nullptr)
+            ChunkPtr erase(int cx, int cz) {
+                if (m_entries.empty()) return nullptr;
+                const uint64_t key = pack_key(cx, cz);
+
+                size_t i = hash(key) & m_mask;
+                for (;; i = (i + 1) & m_mask) {
+                    if (m_slots[i].index == EMPTY) return nullptr;
+                    if (m_slots[i].key == key) break;
+                }
+
+                const uint32_t index = m_slots[i].index;
+                ChunkPtr removed = std::move(m_entries[index].chunk);
+
+                // 後方シフト削除: 後続のクラスタを詰めて探査列を保つ
+                size_t hole = i;
+                for (size_t j = (i + 1) & m_mask;; j = (j + 1) & m_mask) {
+                    if (m_slots[j].index == EMPTY) break;
+                    size_t home = hash(m_slots[j].key) & m_mask;
+                    // home が (hole, j] の範囲外なら hole へ移動できる
+                    if (((j - home) & m_mask) >= ((j - hole) & m_mask)) {
+                        m_slots[hole] = m_slots[j];
+                        hole = j;
+                    }
+                }
+                m_slots[hole].index = EMPTY;
+
+                // 密配列は末尾要素で穴を埋める
+                const uint32_t last = static_cast<uint32_t>(m_entries.size() - 1);
+                if (index != last) {
+                    m_entries[index] = std::move(m_entries[last]);
+                    slot_of(m_entries[index].key).index = index;
+                }
+                m_entries.pop_back();
+                return removed;
+            }
+
+            std::vector<Entry>::iterator begin() { return m_entries.begin(); }
+            std::vector<Entry>::iterator end() { return m_entries.end(); }
+            std::vector<Entry>::const_iterator begin() const { return m_entries.begin(); }
+            std::vector<Entry>::const_iterator end() const { return m_entries.end(); }
+
+        private:
+            struct Slot {
+                uint64_t key = 0;
+                uint32_t index = EMPTY;
+            };
+
+            static constexpr uint32_t EMPTY = 0xFFFFFFFFu;
+            // 最大負荷率 3/4 を超えたら倍に拡張
+            static constexpr size_t MAX_LOAD_NUM = 3;
+            static constexpr size_t MAX_LOAD_DEN = 4;
+
+            std::vector<Slot> m_slots;
+            std::vector<Entry> m_entries;
+            size_t m_mask = 0;
+
+            // splitmix64 の最終段: 近い座標同士をスロット全体にばらまく
+            static size_t hash(uint64_t key) {
+                key ^= key >> 30;
+                key *= 0xbf58476d1ce4e5b9ULL;
+                key ^= key >> 27;
+                key *= 0x94d049bb133111ebULL;
+                key ^= key >> 31;
+                return static_cast<size_t>(key);
+            }
+
+            Slot& slot_of(uint64_t key) {
+                size_t i = hash(key) & m_mask;
+                while (m_slots[i].key != key || m_slots[i].index == EMPTY) i = (i + 1) & m_mask;
+                return m_slots[i];
+            }
+
+            void rehash(size_t capacity) {
+                m_slots.assign(capacity, Slot{});
+                m_mask = capacity - 1;
+                for (uint32_t n = 0; n < m_entries.size(); n++) {
+                    size_t i = hash(m_entries[n].key) & m_mask;
+                    while (m_slots[i].index != EMPTY) i = (i + 1) & m_mask;
+                    m_slots[i] = { m_entries[n].key, n };
+                }
+            }
+    };
+} // namespace ocm
@@ -0,0 +1,83 @@
+#include "chunk_snapshot.hpp"
+#include "world.hpp"
+#include <cstring>
+
+namespace ocm {
+    // 面が一切出ないセクションか (単一ブロックで、上下左右前後も単一の不透明ブロック)
+    static bool is_section_hidden(const Chunk& chunk, const Chunk* neighbors[4], int sy) {
+        uint8_t id = 0;
+        if (!chunk.section_uniform(sy, &id)) return false;
+        if (block_info(id).cls == BlockClass::AIR) return true;
+        if (!block_info(id).opaque) return false;
+
+        // 隣接セクションがすべて単一の不透明ブロックなら、境界にも面は出ない
+        auto neighbor_opaque = [&](const Chunk* c, int nsy) {
+            uint8_t nid = 0;
+            return c && c->section_uniform(nsy, &nid) && block_info(nid).opaque;
+        };
+
+        // 最下段のセクションは底面を描かないので下側の判定は不要
+        if (sy > 0 && !neighbor_opaque(&chunk, sy - 1)) return false;
+        if (sy + 1 >= SECTION_COUNT || !neighbor_opaque(&chunk, sy + 1)) return false;
+        for (int i = 0; i < 4; i++) {
+            if (!neighbor_opaque(neighbors[i], sy)) return false;
+        }
+        return true;
+    }
+
+    bool ChunkSnapshot::capture(const World& world, int cx, int cz) {
+        const Chunk* chunk = world.get_chunk_ptr(cx, cz);
+        if (!chunk) return false;
+
+        this->cx = cx;
+        this->cz = cz;
+        this->version = chunk->version;
+        std::memset(blocks, 0, sizeof(blocks)); // AIR
+
+        // X+, X-, Z+, Z-
+        const Chunk* neighbors[4] = {
+            world.get_chunk_ptr(cx + 1, cz),
+            world.get_chunk_ptr(cx - 1, cz),
+            world.get_chunk_ptr(cx, cz + 1),
+            world.get_chunk_ptr(cx, cz - 1),
+        };
+
+        // チャンク本体: セクション単位で展開し、1行 (x方向16個) ずつコピー
+        uint8_t section[SECTION_VOLUME];
+        for (int sy = 0; sy < SECTION_COUNT; sy++) {
+            section_hidden[sy] = is_section_hidden(*chunk, neighbors, sy);
+
+            uint8_t id = 0;
+            if (chunk->section_uniform(sy, &id)) {
+                if (id == 0) continue; // 既に AIR
+                for (int ly = 0; ly < SECTION_SIZE; ly++) {
+                    for (int z = 0; z < CHUNK_SIZE_Z; z++) {
+                        std::memset(&blocks[index(0, sy * SECTION_SIZE + ly, z)], id, CHUNK_SIZE_X);
+                    }
+                }
+                continue;
+            }
+
+            chunk->decode_section(sy, section);
+            for (int ly = 0; ly < SECTION_SIZE; ly++) {
+                for (int z = 0; z < CHUNK_SIZE_Z; z++) {
+                    std::memcpy(&blocks[index(0, sy * SECTION_SIZE + ly, z)],
+                                &section[Chunk::get_index(0, ly, z)], CHUNK_SIZE_X);
+                }
+            }
+        }
+
+        // 境界: 隣接チャンクの接する1列
+        for (int y = 0; y < CHUNK_SIZE_Y; y++) {
+            for (int i = 0; i < CHUNK_SIZE_Z; i++) {
+                if (neighbors[0]) blocks[index(CHUNK_SIZE_X, y, i)] = neighbors[0]->get_block(0, y, i);
+                if (neighbors[1]) blocks[index(-1, y, i)] = neighbors[1]->get_block(CHUNK_SIZE_X - 1, y, i);
+            }
+            for (int i = 0; i < CHUNK_SIZE_X; i++) {
+                if (neighbors[2]) blocks[index(i, y, CHUNK_SIZE_Z)] = neighbors[2]->get_block(i, y, 0);
+                if (neighbors[3]) blocks[index(i, y, -1)] = neighbors[3]->get_block(i, y, CHUNK_SIZE_Z - 1);
+            }
+        }
+        return true;
+    }
+} // namespace ocm
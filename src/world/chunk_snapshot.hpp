@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include "chunk.hpp"
+
+namespace ocm {
+    class World;
+
+    // メッシュ構築用のチャンクのコピー
+    // チャンク本体に隣接4チャンクの境界1ブロックと上下1段を加えた 18x130x18 の連続配列。
+    // 描画スレッドで作成してワーカーへ渡すので、ワーカーは World を参照しない。
+    struct ChunkSnapshot {
+        static constexpr int PAD_X = CHUNK_SIZE_X + 2;
+        static constexpr int PAD_Y = CHUNK_SIZE_Y + 2;
+        static constexpr int PAD_Z = CHUNK_SIZE_Z + 2;
+        static constexpr int PADDED_VOLUME = PAD_X * PAD_Y * PAD_Z;
+
+        // 隣接ブロックへのインデックス差分
+        static constexpr int STRIDE_X = 1;
+        static constexpr int STRIDE_Z = PAD_X;
+        static constexpr int STRIDE_Y = PAD_X * PAD_Z;
+
+        int cx = 0, cz = 0;
+        uint32_t version = 0; // 複製した時点の Chunk::version
+        // 面が一切出ないセクション (build_mesh_data で丸ごと飛ばす)
+        bool section_hidden[SECTION_COUNT] = {};
+        // チャンク外 (未生成の隣接チャンク、y<0, y>=CHUNK_SIZE_Y) は AIR
+        uint8_t blocks[PADDED_VOLUME];
+
+        // チャンクローカル座標 (-1 .. SIZE) からインデックスへ
+        static inline int index(int x, int y, int z) {
+            return (x + 1) * STRIDE_X + (z + 1) * STRIDE_Z + (y + 1) * STRIDE_Y;
+        }
+        uint8_t at(int x, int y, int z) const { return blocks[index(x, y, z)]; }
+
+        // (cx, cz) のチャンクが存在しなければ false
+        bool capture(const World& world, int cx, int cz);
+    };
+} // namespace ocm
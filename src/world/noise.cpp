@@ -0,0 +1,429 @@
+#include "noise.hpp"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define OCM_NOISE_X86 1
+#endif
+
+namespace ocm {
+    // ---- スカラー版 (World::perlin_noise と同じ式) ----
+
+    static inline float fade(float t) {
+        return t * t * t * (t * (t * 6 - 15) + 10);
+    }
+    static inline float lerp(float a, float b, float t) {
+        return a + t * (b - a);
+    }
+    static inline float grad(int hash, float x, float y, float z) {
+        int h = hash & 15;
+        float u = h < 8 ? x : y;
+        float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+        return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+    }
+
+    float perlin_noise(const int* p, float x, float y, float z) {
+        int X = static_cast<int>(std::floor(x)) & 255;
+        int Y = static_cast<int>(std::floor(y)) & 255;
+        int Z = static_cast<int>(std::floor(z)) & 255;
+
+        x -= std::floor(x);
+        y -= std::floor(y);
+        z -= std::floor(z);
+
+        float u = fade(x);
+        float v = fade(y);
+        float w = fade(z);
+
+        int A = p[X] + Y;
+        int AA = p[A] + Z;
+        int AB = p[A + 1] + Z;
+        int B = p[X + 1] + Y;
+        int BA = p[B] + Z;
+        int BB = p[B + 1] + Z;
+
+        float res = lerp(
+            lerp(lerp(grad(p[AA], x, y, z), grad(p[BA], x - 1, y, z), u),
+                lerp(grad(p[AB], x, y - 1, z), grad(p[BB], x - 1, y - 1, z), u), v),
+            lerp(lerp(grad(p[AA + 1], x, y, z - 1), grad(p[BA + 1], x - 1, y, z - 1), u),
+                lerp(grad(p[AB + 1], x, y - 1, z - 1), grad(p[BB + 1], x - 1, y - 1, z - 1), u), v), w);
+
+        return (res + 1.0f) / 2.0f; // Normalize to [0,1]
+    }
+
+    // 2D 版: 格子の4隅の勾配 (斜め4方向) を補間する。3D 版の半分以下の演算で済む
+    static constexpr float NOISE_2D_SCALE = 0.8f;
+    static inline float grad2(int hash, float x, float y) {
+        return ((hash & 1) == 0 ? x : -x) + ((hash & 2) == 0 ? y : -y);
+    }
+
+    float perlin_noise_2d(const int* p, float x, float y) {
+        int X = static_cast<int>(std::floor(x)) & 255;
+        int Y = static_cast<int>(std::floor(y)) & 255;
+
+        x -= std::floor(x);
+        y -= std::floor(y);
+
+        float u = fade(x);
+        float v = fade(y);
+
+        int A = p[X] + Y;
+        int B = p[X + 1] + Y;
+
+        float res = lerp(
+            lerp(grad2(p[A], x, y), grad2(p[B], x - 1, y), u),
+            lerp(grad2(p[A + 1], x, y - 1), grad2(p[B + 1], x - 1, y - 1), u), v);
+
+        // 3D 版を y 固定で呼んだときと値の広がり (標準偏差) を揃えてから [0,1] へ
+        return (res * NOISE_2D_SCALE + 1.0f) / 2.0f;
+    }
+
+    // fractal_noise / fractal_noise_2d の1点分 (まとめて計算する版の端数にも使う)
+    template <bool TwoD>
+    static float fractal_noise_scalar(const int* p, float x, float z, int octaves, float persistence, float lacunarity) {
+        float total = 0.0f;
+        float frequency = 1.0f;
+        float amplitude = 1.0f;
+        float maxValue = 0.0f;
+        for (int o = 0; o < octaves; o++) {
+            float n = TwoD ? perlin_noise_2d(p, x * frequency, z * frequency)
+                           : perlin_noise(p, x * frequency, 0.1f, z * frequency);
+            total += n * amplitude;
+            maxValue += amplitude;
+            amplitude *= persistence;
+            frequency *= lacunarity;
+        }
+        return total / maxValue;
+    }
+
+#ifdef OCM_NOISE_X86
+    // ---- SSE2 (4 点) ----
+    // スカラー版と同じ順に同じ単精度演算を行う (FMA に置き換わらないよう、積和は分けて書く)
+
+    // floor の整数値と小数部 (|x| < 2^31)
+    static inline __m128 floor4(__m128 x, __m128i& xi) {
+        __m128i t = _mm_cvttps_epi32(x);
+        __m128 tf = _mm_cvtepi32_ps(t);
+        __m128 over = _mm_cmpgt_ps(tf, x); // 負の非整数は切り捨てで1大きくなる
+        xi = _mm_add_epi32(t, _mm_castps_si128(over));
+        return _mm_sub_ps(tf, _mm_and_ps(over, _mm_set1_ps(1.0f)));
+    }
+    static inline __m128 fade4(__m128 t) {
+        __m128 t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+        __m128 inner = _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f));
+        return _mm_mul_ps(t3, _mm_add_ps(_mm_mul_ps(t, inner), _mm_set1_ps(10.0f)));
+    }
+    static inline __m128 lerp4(__m128 a, __m128 b, __m128 t) {
+        return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+    }
+    static inline __m128 select4(__m128i mask, __m128 a, __m128 b) {
+        __m128 m = _mm_castsi128_ps(mask);
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+    static inline __m128 grad4(__m128i hash, __m128 x, __m128 y, __m128 z) {
+        __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+        __m128 u = select4(_mm_cmplt_epi32(h, _mm_set1_epi32(8)), x, y);
+        __m128i xz = _mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14)));
+        __m128 v = select4(_mm_cmplt_epi32(h, _mm_set1_epi32(4)), y, select4(xz, x, z));
+        // bit 0 / bit 1 が立っていれば符号を反転 (単項マイナスと同じく符号ビットのみ変わる)
+        __m128 su = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+        __m128 sv = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+        return _mm_add_ps(_mm_xor_ps(u, su), _mm_xor_ps(v, sv));
+    }
+    // SSE2 には gather がないので、添字を書き出して引く
+    static inline __m128i gather4(const int* p, __m128i index) {
+        alignas(16) int i[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(i), index);
+        return _mm_setr_epi32(p[i[0]], p[i[1]], p[i[2]], p[i[3]]);
+    }
+
+    static inline __m128 perlin4(const int* p, __m128 x, __m128 y, __m128 z) {
+        const __m128i mask = _mm_set1_epi32(255);
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128 onef = _mm_set1_ps(1.0f);
+        __m128i X, Y, Z;
+        x = _mm_sub_ps(x, floor4(x, X));
+        y = _mm_sub_ps(y, floor4(y, Y));
+        z = _mm_sub_ps(z, floor4(z, Z));
+        X = _mm_and_si128(X, mask);
+        Y = _mm_and_si128(Y, mask);
+        Z = _mm_and_si128(Z, mask);
+
+        __m128 u = fade4(x), v = fade4(y), w = fade4(z);
+
+        __m128i A = _mm_add_epi32(gather4(p, X), Y);
+        __m128i AA = _mm_add_epi32(gather4(p, A), Z);
+        __m128i AB = _mm_add_epi32(gather4(p, _mm_add_epi32(A, one)), Z);
+        __m128i B = _mm_add_epi32(gather4(p, _mm_add_epi32(X, one)), Y);
+        __m128i BA = _mm_add_epi32(gather4(p, B), Z);
+        __m128i BB = _mm_add_epi32(gather4(p, _mm_add_epi32(B, one)), Z);
+
+        __m128 x1 = _mm_sub_ps(x, onef), y1 = _mm_sub_ps(y, onef), z1 = _mm_sub_ps(z, onef);
+        __m128 res = lerp4(
+            lerp4(lerp4(grad4(gather4(p, AA), x, y, z), grad4(gather4(p, BA), x1, y, z), u),
+                  lerp4(grad4(gather4(p, AB), x, y1, z), grad4(gather4(p, BB), x1, y1, z), u), v),
+            lerp4(lerp4(grad4(gather4(p, _mm_add_epi32(AA, one)), x, y, z1), grad4(gather4(p, _mm_add_epi32(BA, one)), x1, y, z1), u),
+                  lerp4(grad4(gather4(p, _mm_add_epi32(AB, one)), x, y1, z1), grad4(gather4(p, _mm_add_epi32(BB, one)), x1, y1, z1), u), v), w);
+
+        return _mm_div_ps(_mm_add_ps(res, onef), _mm_set1_ps(2.0f));
+    }
+
+    static inline __m128 grad2_4(__m128i hash, __m128 x, __m128 y) {
+        __m128 su = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(hash, _mm_set1_epi32(1)), 31));
+        __m128 sv = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(hash, _mm_set1_epi32(2)), 30));
+        return _mm_add_ps(_mm_xor_ps(x, su), _mm_xor_ps(y, sv));
+    }
+
+    static inline __m128 perlin2d4(const int* p, __m128 x, __m128 y) {
+        const __m128i mask = _mm_set1_epi32(255);
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128 onef = _mm_set1_ps(1.0f);
+        __m128i X, Y;
+        x = _mm_sub_ps(x, floor4(x, X));
+        y = _mm_sub_ps(y, floor4(y, Y));
+        X = _mm_and_si128(X, mask);
+        Y = _mm_and_si128(Y, mask);
+
+        __m128 u = fade4(x), v = fade4(y);
+
+        __m128i A = _mm_add_epi32(gather4(p, X), Y);
+        __m128i B = _mm_add_epi32(gather4(p, _mm_add_epi32(X, one)), Y);
+
+        __m128 x1 = _mm_sub_ps(x, onef), y1 = _mm_sub_ps(y, onef);
+        __m128 res = lerp4(
+            lerp4(grad2_4(gather4(p, A), x, y), grad2_4(gather4(p, B), x1, y), u),
+            lerp4(grad2_4(gather4(p, _mm_add_epi32(A, one)), x, y1), grad2_4(gather4(p, _mm_add_epi32(B, one)), x1, y1), u), v);
+
+        return _mm_div_ps(_mm_add_ps(_mm_mul_ps(res, _mm_set1_ps(NOISE_2D_SCALE)), onef), _mm_set1_ps(2.0f));
+    }
+
+    static void perlin_noise_sse2(const int* p, const float* x, const float* y, const float* z, float* out, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, perlin4(p, _mm_loadu_ps(x + i), _mm_loadu_ps(y + i), _mm_loadu_ps(z + i)));
+        }
+        for (; i < n; i++) out[i] = perlin_noise(p, x[i], y[i], z[i]);
+    }
+
+    static void perlin_noise_2d_sse2(const int* p, const float* x, const float* y, float* out, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(out + i, perlin2d4(p, _mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+        }
+        for (; i < n; i++) out[i] = perlin_noise_2d(p, x[i], y[i]);
+    }
+
+    template <bool TwoD>
+    static void fractal_noise_sse2(const int* p, const float* x, const float* z, float* out, size_t n,
+                                   int octaves, float persistence, float lacunarity) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 bx = _mm_loadu_ps(x + i), bz = _mm_loadu_ps(z + i);
+            __m128 total = _mm_setzero_ps();
+            float frequency = 1.0f, amplitude = 1.0f, maxValue = 0.0f;
+            for (int o = 0; o < octaves; o++) {
+                __m128 f = _mm_set1_ps(frequency);
+                __m128 n4;
+                if constexpr (TwoD) n4 = perlin2d4(p, _mm_mul_ps(bx, f), _mm_mul_ps(bz, f));
+                else n4 = perlin4(p, _mm_mul_ps(bx, f), _mm_set1_ps(0.1f), _mm_mul_ps(bz, f));
+                total = _mm_add_ps(total, _mm_mul_ps(n4, _mm_set1_ps(amplitude)));
+                maxValue += amplitude;
+                amplitude *= persistence;
+                frequency *= lacunarity;
+            }
+            _mm_storeu_ps(out + i, _mm_div_ps(total, _mm_set1_ps(maxValue)));
+        }
+        for (; i < n; i++) out[i] = fractal_noise_scalar<TwoD>(p, x[i], z[i], octaves, persistence, lacunarity);
+    }
+
+    // ---- AVX2 (8 点、置換表は gather で引く) ----
+#pragma GCC push_options
+#pragma GCC target("avx2")
+    static inline __m256 floor8(__m256 x, __m256i& xi) {
+        __m256i t = _mm256_cvttps_epi32(x);
+        __m256 tf = _mm256_cvtepi32_ps(t);
+        __m256 over = _mm256_cmp_ps(tf, x, _CMP_GT_OQ);
+        xi = _mm256_add_epi32(t, _mm256_castps_si256(over));
+        return _mm256_sub_ps(tf, _mm256_and_ps(over, _mm256_set1_ps(1.0f)));
+    }
+    static inline __m256 fade8(__m256 t) {
+        __m256 t3 = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+        __m256 inner = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f));
+        return _mm256_mul_ps(t3, _mm256_add_ps(_mm256_mul_ps(t, inner), _mm256_set1_ps(10.0f)));
+    }
+    static inline __m256 lerp8(__m256 a, __m256 b, __m256 t) {
+        return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+    }
+    static inline __m256 grad8(__m256i hash, __m256 x, __m256 y, __m256 z) {
+        __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+        __m256 lt8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h));
+        __m256 lt4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+        __m256 xz = _mm256_castsi256_ps(_mm256_or_si256(_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)),
+                                                        _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14))));
+        __m256 u = _mm256_blendv_ps(y, x, lt8);
+        __m256 v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, xz), y, lt4);
+        __m256 su = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+        __m256 sv = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+        return _mm256_add_ps(_mm256_xor_ps(u, su), _mm256_xor_ps(v, sv));
+    }
+    static inline __m256i gather8(const int* p, __m256i index) {
+        return _mm256_i32gather_epi32(p, index, 4);
+    }
+
+    static inline __m256 perlin8(const int* p, __m256 x, __m256 y, __m256 z) {
+        const __m256i mask = _mm256_set1_epi32(255);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256 onef = _mm256_set1_ps(1.0f);
+        __m256i X, Y, Z;
+        x = _mm256_sub_ps(x, floor8(x, X));
+        y = _mm256_sub_ps(y, floor8(y, Y));
+        z = _mm256_sub_ps(z, floor8(z, Z));
+        X = _mm256_and_si256(X, mask);
+        Y = _mm256_and_si256(Y, mask);
+        Z = _mm256_and_si256(Z, mask);
+
+        __m256 u = fade8(x), v = fade8(y), w = fade8(z);
+
+        __m256i A = _mm256_add_epi32(gather8(p, X), Y);
+        __m256i AA = _mm256_add_epi32(gather8(p, A), Z);
+        __m256i AB = _mm256_add_epi32(gather8(p, _mm256_add_epi32(A, one)), Z);
+        __m256i B = _mm256_add_epi32(gather8(p, _mm256_add_epi32(X, one)), Y);
+        __m256i BA = _mm256_add_epi32(gather8(p, B), Z);
+        __m256i BB = _mm256_add_epi32(gather8(p, _mm256_add_epi32(B, one)), Z);
+
+        __m256 x1 = _mm256_sub_ps(x, onef), y1 = _mm256_sub_ps(y, onef), z1 = _mm256_sub_ps(z, onef);
+        __m256 res = lerp8(
+            lerp8(lerp8(grad8(gather8(p, AA), x, y, z), grad8(gather8(p, BA), x1, y, z), u),
+                  lerp8(grad8(gather8(p, AB), x, y1, z), grad8(gather8(p, BB), x1, y1, z), u), v),
+            lerp8(lerp8(grad8(gather8(p, _mm256_add_epi32(AA, one)), x, y, z1), grad8(gather8(p, _mm256_add_epi32(BA, one)), x1, y, z1), u),
+                  lerp8(grad8(gather8(p, _mm256_add_epi32(AB, one)), x, y1, z1), grad8(gather8(p, _mm256_add_epi32(BB, one)), x1, y1, z1), u), v), w);
+
+        return _mm256_div_ps(_mm256_add_ps(res, onef), _mm256_set1_ps(2.0f));
+    }
+
+    static inline __m256 grad2_8(__m256i hash, __m256 x, __m256 y) {
+        __m256 su = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(hash, _mm256_set1_epi32(1)), 31));
+        __m256 sv = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(hash, _mm256_set1_epi32(2)), 30));
+        return _mm256_add_ps(_mm256_xor_ps(x, su), _mm256_xor_ps(y, sv));
+    }
+
+    static inline __m256 perlin2d8(const int* p, __m256 x, __m256 y) {
+        const __m256i mask = _mm256_set1_epi32(255);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256 onef = _mm256_set1_ps(1.0f);
+        __m256i X, Y;
+        x = _mm256_sub_ps(x, floor8(x, X));
+        y = _mm256_sub_ps(y, floor8(y, Y));
+        X = _mm256_and_si256(X, mask);
+        Y = _mm256_and_si256(Y, mask);
+
+        __m256 u = fade8(x), v = fade8(y);
+
+        __m256i A = _mm256_add_epi32(gather8(p, X), Y);
+        __m256i B = _mm256_add_epi32(gather8(p, _mm256_add_epi32(X, one)), Y);
+
+        __m256 x1 = _mm256_sub_ps(x, onef), y1 = _mm256_sub_ps(y, onef);
+        __m256 res = lerp8(
+            lerp8(grad2_8(gather8(p, A), x, y), grad2_8(gather8(p, B), x1, y), u),
+            lerp8(grad2_8(gather8(p, _mm256_add_epi32(A, one)), x, y1), grad2_8(gather8(p, _mm256_add_epi32(B, one)), x1, y1), u), v);
+
+        return _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(res, _mm256_set1_ps(NOISE_2D_SCALE)), onef), _mm256_set1_ps(2.0f));
+    }
+
+    static void perlin_noise_avx2(const int* p, const float* x, const float* y, const float* z, float* out, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(out + i, perlin8(p, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), _mm256_loadu_ps(z + i)));
+        }
+        if (i < n) perlin_noise_sse2(p, x + i, y + i, z + i, out + i, n - i);
+    }
+
+    static void perlin_noise_2d_avx2(const int* p, const float* x, const float* y, float* out, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(out + i, perlin2d8(p, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+        }
+        if (i < n) perlin_noise_2d_sse2(p, x + i, y + i, out + i, n - i);
+    }
+
+    template <bool TwoD>
+    static void fractal_noise_avx2(const int* p, const float* x, const float* z, float* out, size_t n,
+                                   int octaves, float persistence, float lacunarity) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256 bx = _mm256_loadu_ps(x + i), bz = _mm256_loadu_ps(z + i);
+            __m256 total = _mm256_setzero_ps();
+            float frequency = 1.0f, amplitude = 1.0f, maxValue = 0.0f;
+            for (int o = 0; o < octaves; o++) {
+                __m256 f = _mm256_set1_ps(frequency);
+                __m256 n8;
+                if constexpr (TwoD) n8 = perlin2d8(p, _mm256_mul_ps(bx, f), _mm256_mul_ps(bz, f));
+                else n8 = perlin8(p, _mm256_mul_ps(bx, f), _mm256_set1_ps(0.1f), _mm256_mul_ps(bz, f));
+                total = _mm256_add_ps(total, _mm256_mul_ps(n8, _mm256_set1_ps(amplitude)));
+                maxValue += amplitude;
+                amplitude *= persistence;
+                frequency *= lacunarity;
+            }
+            _mm256_storeu_ps(out + i, _mm256_div_ps(total, _mm256_set1_ps(maxValue)));
+        }
+        if (i < n) fractal_noise_sse2<TwoD>(p, x + i, z + i, out + i, n - i, octaves, persistence, lacunarity);
+    }
+#pragma GCC pop_options
+#endif // OCM_NOISE_X86
+
+    NoiseIsa noise_isa() {
+#ifdef OCM_NOISE_X86
+        static const NoiseIsa isa = __builtin_cpu_supports("avx2") ? NoiseIsa::AVX2 : NoiseIsa::SSE2;
+        return isa;
+#else
+        return NoiseIsa::SCALAR;
+#endif
+    }
+
+    const char* noise_isa_name(NoiseIsa isa) {
+        switch (isa) {
+            case NoiseIsa::AVX2: return "avx2";
+            case NoiseIsa::SSE2: return "sse2";
+            case NoiseIsa::SCALAR:
+            default: return "scalar";
+        }
+    }
+
+    void perlin_noise_batch(const int* perm, const float* x, const float* y, const float* z, float* out, size_t n, NoiseIsa isa) {
+#ifdef OCM_NOISE_X86
+        if (isa == NoiseIsa::AVX2) return perlin_noise_avx2(perm, x, y, z, out, n);
+        if (isa == NoiseIsa::SSE2) return perlin_noise_sse2(perm, x, y, z, out, n);
+#endif
+        for (size_t i = 0; i < n; i++) out[i] = perlin_noise(perm, x[i], y[i], z[i]);
+    }
+
+    void fractal_noise_batch(const int* perm, const float* x, const float* z, float* out, size_t n,
+                             int octaves, float persistence, float lacunarity, NoiseIsa isa) {
+#ifdef OCM_NOISE_X86
+        if (isa == NoiseIsa::AVX2) return fractal_noise_avx2<false>(perm, x, z, out, n, octaves, persistence, lacunarity);
+        if (isa == NoiseIsa::SSE2) return fractal_noise_sse2<false>(perm, x, z, out, n, octaves, persistence, lacunarity);
+#endif
+        for (size_t i = 0; i < n; i++) out[i] = fractal_noise_scalar<false>(perm, x[i], z[i], octaves, persistence, lacunarity);
+    }
+
+    void perlin_noise_2d_batch(const int* perm, const float* x, const float* y, float* out, size_t n, NoiseIsa isa) {
+#ifdef OCM_NOISE_X86
+        if (isa == NoiseIsa::AVX2) return perlin_noise_2d_avx2(perm, x, y, out, n);
+        if (isa == NoiseIsa::SSE2) return perlin_noise_2d_sse2(perm, x, y, out, n);
+#endif
+        for (size_t i = 0; i < n; i++) out[i] = perlin_noise_2d(perm, x[i], y[i]);
+    }
+
+    void fractal_noise_2d_batch(const int* perm, const float* x, const float* z, float* out, size_t n,
+                                int octaves, float persistence, float lacunarity, NoiseIsa isa) {
+#ifdef OCM_NOISE_X86
+        if (isa == NoiseIsa::AVX2) return fractal_noise_avx2<true>(perm, x, z, out, n, octaves, persistence, lacunarity);
+        if (isa == NoiseIsa::SSE2) return fractal_noise_sse2<true>(perm, x, z, out, n, octaves, persistence, lacunarity);
+#endif
+        for (size_t i = 0; i < n; i++) out[i] = fractal_noise_scalar<true>(perm, x[i], z[i], octaves, persistence, lacunarity);
+    }
+
+    float fractal_noise_2d(const int* perm, float x, float z, int octaves, float persistence, float lacunarity) {
+        return fractal_noise_scalar<true>(perm, x, z, octaves, persistence, lacunarity);
+    }
+} // namespace ocm
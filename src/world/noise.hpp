@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ocm {
+    // World::perlin_noise / fractal_noise (と 2D 版) を複数の点でまとめて計算する
+    // 4 点 (SSE2) / 8 点 (AVX2) ずつ同じ手順の演算を並べるので、結果はスカラー版とビット単位で一致する (test/test_noise.cpp)。
+    // perm は World の置換表 (512 要素、後半は前半の複製)
+    enum class NoiseIsa {
+        SCALAR,
+        SSE2,
+        AVX2,
+    };
+    // この CPU で使える最も広い命令セット (初回に判定)
+    NoiseIsa noise_isa();
+    const char* noise_isa_name(NoiseIsa isa);
+
+    // 1点のみ (World::perlin_noise の本体)
+    float perlin_noise(const int* perm, float x, float y, float z);
+
+    // out[i] = perlin_noise(x[i], y[i], z[i])
+    void perlin_noise_batch(const int* perm, const float* x, const float* y, const float* z, float* out, size_t n,
+                            NoiseIsa isa = noise_isa());
+    // out[i] = fractal_noise(x[i], z[i], octaves, persistence, lacunarity)
+    void fractal_noise_batch(const int* perm, const float* x, const float* z, float* out, size_t n,
+                             int octaves, float persistence, float lacunarity, NoiseIsa isa = noise_isa());
+
+    // 2D のグラディエントノイズ (0..1)。高さマップのように水平面だけで決まる層に使う
+    // 3D 版を y 固定で呼ぶのと比べ、勾配は4つ・補間は3回で済む
+    float perlin_noise_2d(const int* perm, float x, float y);
+    float fractal_noise_2d(const int* perm, float x, float z, int octaves, float persistence, float lacunarity);
+    void perlin_noise_2d_batch(const int* perm, const float* x, const float* y, float* out, size_t n,
+                               NoiseIsa isa = noise_isa());
+    void fractal_noise_2d_batch(const int* perm, const float* x, const float* z, float* out, size_t n,
+                                int octaves, float persistence, float lacunarity, NoiseIsa isa = noise_isa());
+} // namespace ocm
@@ -0,0 +1,95 @@
+#include "section_visibility.hpp"
+#include "chunk_snapshot.hpp"
+#include "../block/block.hpp"
+#include <algorithm>
+#include <bitset>
+#include <vector>
+
+namespace ocm {
+    FaceConnectivity compute_face_connectivity(const ChunkSnapshot& snapshot, int sy) {
+        // セクション内のセル (x + z * 16 + y * 256)
+        constexpr int SX = 1, SZ = CHUNK_SIZE_X, SY = CHUNK_SIZE_X * CHUNK_SIZE_Z;
+        const int y0 = sy * SECTION_SIZE;
+
+        std::bitset<SECTION_VOLUME> open; // 不透明でないセル (塗ったら消す)
+        for (int y = 0; y < SECTION_SIZE; y++) {
+            for (int z = 0; z < CHUNK_SIZE_Z; z++) {
+                int idx = ChunkSnapshot::index(0, y0 + y, z);
+                for (int x = 0; x < CHUNK_SIZE_X; x++, idx++) {
+                    if (!block_info(snapshot.blocks[idx]).opaque) open.set(x * SX + z * SZ + y * SY);
+                }
+            }
+        }
+        if (open.none()) return 0;
+        if (open.all()) return ALL_FACES_CONNECTED;
+
+        // セルが接している面 (FaceDirection のビット)
+        auto faces_of = [](int x, int y, int z) {
+            uint32_t faces = 0;
+            if (z == CHUNK_SIZE_Z - 1) faces |= 1u << SIDE_FRONT;
+            if (z == 0)                faces |= 1u << SIDE_BACK;
+            if (y == SECTION_SIZE - 1) faces |= 1u << TOP;
+            if (y == 0)                faces |= 1u << BOTTOM;
+            if (x == CHUNK_SIZE_X - 1) faces |= 1u << SIDE_RIGHT;
+            if (x == 0)                faces |= 1u << SIDE_LEFT;
+            return faces;
+        };
+
+        FaceConnectivity connectivity = 0;
+        std::vector<int> stack;
+        stack.reserve(SECTION_VOLUME);
+        for (int start = 0; start < SECTION_VOLUME; start++) {
+            if (!open.test(start)) continue;
+
+            // start から塗りつぶし、この領域が触れる面を集める
+            uint32_t touched = 0;
+            open.reset(start);
+            stack.push_back(start);
+            while (!stack.empty()) {
+                int cell = stack.back();
+                stack.pop_back();
+                int x = cell % CHUNK_SIZE_X, z = (cell / SZ) % CHUNK_SIZE_Z, y = cell / SY;
+                uint32_t faces = faces_of(x, y, z);
+                touched |= faces;
+
+                auto visit = [&](int next) {
+                    if (open.test(next)) {
+                        open.reset(next);
+                        stack.push_back(next);
+                    }
+                };
+                if (!(faces & (1u << SIDE_RIGHT))) visit(cell + SX);
+                if (!(faces & (1u << SIDE_LEFT)))  visit(cell - SX);
+                if (!(faces & (1u << SIDE_FRONT))) visit(cell + SZ);
+                if (!(faces & (1u << SIDE_BACK)))  visit(cell - SZ);
+                if (!(faces & (1u << TOP)))        visit(cell + SY);
+                if (!(faces & (1u << BOTTOM)))     visit(cell - SY);
+            }
+
+            for (int a = 0; a < 6; a++) {
+                if (!(touched & (1u << a))) continue;
+                for (int b = 0; b < 6; b++) {
+                    if (touched & (1u << b)) connectivity |= FaceConnectivity(1) << (a * 6 + b);
+                }
+            }
+            if (connectivity == ALL_FACES_CONNECTED) break;
+        }
+        return connectivity;
+    }
+
+    void compute_solid_heights(const ChunkSnapshot& snapshot, uint8_t* out) {
+        for (int cell = 0; cell < SOLID_CELLS * SOLID_CELLS; cell++) {
+            int x0 = (cell % SOLID_CELLS) * SOLID_CELL_SIZE;
+            int z0 = (cell / SOLID_CELLS) * SOLID_CELL_SIZE;
+            int height = CHUNK_SIZE_Y;
+            for (int z = z0; z < z0 + SOLID_CELL_SIZE && height > 0; z++) {
+                for (int x = x0; x < x0 + SOLID_CELL_SIZE && height > 0; x++) {
+                    int y = 0;
+                    while (y < height && block_info(snapshot.at(x, y, z)).opaque) y++;
+                    height = y;
+                }
+            }
+            out[cell] = static_cast<uint8_t>(std::min(height, 255));
+        }
+    }
+} // namespace ocm
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include "chunk.hpp"
+
+namespace ocm {
+    struct ChunkSnapshot;
+
+    // セクションの6面のうち、不透明でないブロックを通ってつながっている面の組
+    // bit (a * 6 + b) が立っていれば面 a から面 b へ抜けられる (a, b は FaceDirection)
+    using FaceConnectivity = uint64_t;
+    constexpr FaceConnectivity ALL_FACES_CONNECTED = (FaceConnectivity(1) << 36) - 1;
+
+    inline bool faces_connected(FaceConnectivity connectivity, int a, int b) {
+        return (connectivity >> (a * 6 + b)) & 1;
+    }
+    // 面 d の反対側の面 (FaceDirection は向かい合う面が隣り合う順に並んでいる)
+    inline int opposite_face(int d) { return d ^ 1; }
+
+    // セクション sy の中を不透明でないブロックで塗りつぶし、同じ領域が触れる面どうしをつなぐ
+    FaceConnectivity compute_face_connectivity(const ChunkSnapshot& snapshot, int sy);
+
+    // チャンクを水平に SOLID_CELLS x SOLID_CELLS の区画に分け、区画内の全ての列で y = 0 から
+    // 不透明なブロックが途切れずに続く高さを求める (out[cx + cz * SOLID_CELLS]、遮蔽物の箱に使う)
+    constexpr int SOLID_CELLS = 2;
+    constexpr int SOLID_CELL_SIZE = CHUNK_SIZE_X / SOLID_CELLS;
+    void compute_solid_heights(const ChunkSnapshot& snapshot, uint8_t* out);
+} // namespace ocm
@@ -1,12 +1,13 @@
 #include "world.hpp"
 #include "structures.hpp"
+#include "noise.hpp"
 #include <algorithm>
 #include <cstdio>
 #include <cmath>
+#include <condition_variable>
 #include <cinttypes>
 #include <iostream>
 #include <numeric>
-#include <map>
 #include <random>
 
 namespace ocm {
@@ -29,6 +30,8 @@ namespace ocm {
     void World::init(uint32_t seed) {
         m_seed = seed;
         m_chunks.clear();
+        m_genPending.clear();
+        m_genResults.clear();
 
         // 置換テーブル p をシード値に基づいてシャッフル
         p.resize(256);
@@ -45,6 +48,10 @@ namespace ocm {
     }
 
     void World::destroy() {
+        // 生成中のタスクが m_chunks 以外の状態も参照するので、先にワーカーを止める
+        m_genPool.reset();
+        m_genPending.clear();
+        m_genResults.clear();
         m_chunks.clear();
     }
 
@@ -65,32 +72,8 @@ namespace ocm {
     }
 
     float World::perlin_noise(float x, float y, float z) const {
-        int X = static_cast<int>(std::floor(x)) & 255;
-        int Y = static_cast<int>(std::floor(y)) & 255;
-        int Z = static_cast<int>(std::floor(z)) & 255;
-
-        x -= std::floor(x);
-        y -= std::floor(y);
-        z -= std::floor(z);
-
-        float u = fade(x);
-        float v = fade(y);
-        float w = fade(z);
-
-        int A = p[X] + Y;
-        int AA = p[A] + Z;
-        int AB = p[A + 1] + Z;
-        int B = p[X + 1] + Y;
-        int BA = p[B] + Z;
-        int BB = p[B + 1] + Z;
-
-        float res = lerp(
-            lerp(lerp(grad(p[AA], x, y, z), grad(p[BA], x - 1, y, z), u),
-                lerp(grad(p[AB], x, y - 1, z), grad(p[BB], x - 1, y - 1, z), u), v),
-            lerp(lerp(grad(p[AA + 1], x, y, z - 1), grad(p[BA + 1], x - 1, y, z - 1), u),
-                lerp(grad(p[AB + 1], x, y - 1, z - 1), grad(p[BB + 1], x - 1, y - 1, z - 1), u), v), w);
-
-        return (res + 1.0f) / 2.0f; // Normalize to [0,1]
+        // 本体はまとめて計算する版 (noise.cpp) と共有する
+        return ocm::perlin_noise(p.data(), x, y, z);
     }
 
     float World::fractal_noise(float x, float z, int octaves, float persistence, float lacunarity) const {
@@ -110,61 +93,169 @@ namespace ocm {
         return total / maxValue;
     }
 
-    float World::get_noise_random(int x, int z) {
-        unsigned int n = (unsigned int)(x * 374761393 + z * 668265263 + m_seed);
+    float World::perlin_noise_2d(float x, float z) const {
+        return ocm::perlin_noise_2d(p.data(), x, z);
+    }
+
+    float World::fractal_noise_2d(float x, float z, int octaves, float persistence, float lacunarity) const {
+        return ocm::fractal_noise_2d(p.data(), x, z, octaves, persistence, lacunarity);
+    }
+
+    float World::get_noise_random(int x, int z) const {
+        // 符号付き整数のオーバーフローは未定義動作なので符号なしで計算する
+        unsigned int n = (unsigned int)x * 374761393u + (unsigned int)z * 668265263u + m_seed;
         n = (n ^ (n >> 13)) * 1274126177;
         return (float)(n & 0x7fffffff) / 0x7fffffff;
     }
 
-    void World::generate_chunk(int cx, int cz) {
-        // 複数のチャンクを管理する場合、 
-        // std::map<std::pair<int, int>, ChunkPtr> m_chunks 等での管理が理想です
+    void World::set_noise_sampling(int step) {
+        // 格子点がチャンクの境界に乗る間隔のみ (隣のチャンクと同じ格子点を共有するので境界で段差ができない)
+        m_noiseStep = (step >= 2 && step <= CHUNK_SIZE_X && CHUNK_SIZE_X % step == 0 && CHUNK_SIZE_Z % step == 0) ? step : 0;
+    }
+
+    // チャンク (cx, cz) の全カラムのノイズの層を求める (step が 0 なら fractal_noise_2d と同じ値)
+    // 粗い格子で求めたオクターブも、足し合わせる順番と重みは fractal_noise_2d と同じ
+    void World::sample_columns(int cx, int cz, int step, ColumnNoise& out) const {
+        // シード値によるオフセット
+        const float offsetX = static_cast<float>(m_seed % 10000);
+        const float offsetZ = static_cast<float>((m_seed / 10000) % 10000);
+        const float lacunarity = 2.0f;
+
+        float noise_x[COLUMNS], noise_z[COLUMNS];
+        float octave_x[COLUMNS], octave_z[COLUMNS], octave[COLUMNS];
+
+        // 格子点 (チャンクの原点から step 刻み、両端を含む。格子点 j = gx * lattice_z + gz)
+        const int lattice_x = step > 0 ? CHUNK_SIZE_X / step + 1 : 0;
+        const int lattice_z = step > 0 ? CHUNK_SIZE_Z / step + 1 : 0;
+        const int lattice_points = lattice_x * lattice_z;
+        float lattice_nx[COLUMNS], lattice_nz[COLUMNS], lattice_total[COLUMNS];
+
+        auto noise_layer = [&](float scale, int octaves, float persistence, float* result) {
+            for (int i = 0; i < COLUMNS; i++) {
+                float world_x = static_cast<float>(cx * CHUNK_SIZE_X + i / CHUNK_SIZE_Z);
+                float world_z = static_cast<float>(cz * CHUNK_SIZE_Z + i % CHUNK_SIZE_Z);
+                noise_x[i] = world_x * scale + offsetX;
+                noise_z[i] = world_z * scale + offsetZ;
+            }
+            // 最も低いオクターブでも格子に載らなければ全カラムで計算する
+            const float lattice_limit = static_cast<float>(step * NOISE_LATTICE_WAVELENGTHS);
+            if (step == 0 || scale * lattice_limit > 1.0f) {
+                fractal_noise_2d_batch(p.data(), noise_x, noise_z, result, COLUMNS, octaves, persistence, lacunarity);
+                out.evaluations += static_cast<size_t>(COLUMNS) * octaves;
+                return;
+            }
+
+            for (int j = 0; j < lattice_points; j++) {
+                float world_x = static_cast<float>(cx * CHUNK_SIZE_X + (j / lattice_z) * step);
+                float world_z = static_cast<float>(cz * CHUNK_SIZE_Z + (j % lattice_z) * step);
+                lattice_nx[j] = world_x * scale + offsetX;
+                lattice_nz[j] = world_z * scale + offsetZ;
+            }
+
+            // 格子に載るオクターブは格子点で足し合わせておき、最後に1回だけ補間する (補間は線形なので同じ値)
+            std::fill(result, result + COLUMNS, 0.0f);
+            std::fill(lattice_total, lattice_total + lattice_points, 0.0f);
+            float frequency = 1.0f;
+            float amplitude = 1.0f;
+            float maxValue = 0.0f;
+            for (int o = 0; o < octaves; o++) {
+                const bool coarse = scale * frequency * lattice_limit <= 1.0f;
+                const int count = coarse ? lattice_points : COLUMNS;
+                const float* nx = coarse ? lattice_nx : noise_x;
+                const float* nz = coarse ? lattice_nz : noise_z;
+                float* total = coarse ? lattice_total : result;
+                for (int i = 0; i < count; i++) {
+                    octave_x[i] = nx[i] * frequency;
+                    octave_z[i] = nz[i] * frequency;
+                }
+                perlin_noise_2d_batch(p.data(), octave_x, octave_z, octave, count);
+                for (int i = 0; i < count; i++) total[i] += octave[i] * amplitude;
+                out.evaluations += count;
+
+                maxValue += amplitude;
+                amplitude *= persistence;
+                frequency *= lacunarity;
+            }
+
+            // 双線形補間 (まず格子の各列を z 方向に、次に x 方向に)
+            const float inv_step = 1.0f / static_cast<float>(step);
+            float along_z[COLUMNS]; // [gx * CHUNK_SIZE_Z + z]
+            for (int gx = 0; gx < lattice_x; gx++) {
+                const float* row = &lattice_total[gx * lattice_z];
+                for (int z = 0; z < CHUNK_SIZE_Z; z++) {
+                    int gz = z / step;
+                    along_z[gx * CHUNK_SIZE_Z + z] = lerp(row[gz], row[gz + 1], static_cast<float>(z - gz * step) * inv_step);
+                }
+            }
+            for (int x = 0; x < CHUNK_SIZE_X; x++) {
+                int gx = x / step;
+                float tx = static_cast<float>(x - gx * step) * inv_step;
+                const float* a = &along_z[gx * CHUNK_SIZE_Z];
+                const float* b = a + CHUNK_SIZE_Z;
+                float* dst = &result[x * CHUNK_SIZE_Z];
+                for (int z = 0; z < CHUNK_SIZE_Z; z++) dst[z] = (dst[z] + lerp(a[z], b[z], tx)) / maxValue;
+            }
+        };
+
+        out.evaluations = 0;
+        noise_layer(0.002f, 3, 0.5f, out.selector);
+        noise_layer(0.01f, 2, 0.5f, out.humidity);
+        noise_layer(0.008f, 3, 0.3f, out.lowland);
+        noise_layer(0.012f, 5, 0.55f, out.mountain);
+        noise_layer(0.005f, 2, 0.5f, out.river);
+    }
+
+    World::ColumnShape World::column_shape(const ColumnNoise& noise, int column) const {
+        ColumnShape shape;
+
+        // 1. バイオーム判定用のノイズ
+        float selector_raw = noise.selector[column];
+        shape.mountain_weight = std::clamp((selector_raw - 0.5f) * 3.3f, 0.0f, 1.0f);
+        shape.humidity = noise.humidity[column];
+
+        // 2. 地形の高さ計算
+        // 平原・砂漠
+        float lowland_height = noise.lowland[column] * 10.0f + 64.0f;
+        // 山岳 (累乗で急傾斜)
+        float mountain_height_raw = noise.mountain[column];
+        mountain_height_raw = std::max(0.0f, mountain_height_raw);
+        float mountain_height = std::pow(mountain_height_raw, 2.0f) * 120.0f + 63.0f;
+
+        // 基本地形の合成
+        float original_height = lerp(lowland_height, mountain_height, shape.mountain_weight);
+
+        // 3. 川の計算
+        float river_n = noise.river[column];
+        float river_v = std::abs(river_n - 0.5f) * 2.0f;
+        float river_mask = std::clamp(river_v / 0.15f, 0.0f, 1.0f);
+
+        // 川の深さ
+        shape.river_depth = 10.0f * (1.0f - river_mask);
+        shape.height = original_height - shape.river_depth;
+        return shape;
+    }
+
+    ChunkPtr World::build_chunk(int cx, int cz) const {
         auto chunk = std::make_unique<Chunk>(cx, cz);
         int terrain_height_map[CHUNK_SIZE_X][CHUNK_SIZE_Z];
 
         // 海面の高さ
         const int SEA_LEVEL = 63;
 
-        // シード値によるオフセット
-        float offsetX = static_cast<float>(m_seed % 10000);
-        float offsetZ = static_cast<float>((m_seed / 10000) % 10000);
+        // ノイズはチャンクの全カラム分を層ごとにまとめて計算する
+        ColumnNoise noise;
+        sample_columns(cx, cz, m_noiseStep, noise);
 
         // 地形配置
         for (int x = 0; x < CHUNK_SIZE_X; x++) {
             for (int z = 0; z < CHUNK_SIZE_Z; z++) {
-                // translate chunk-local coordinates to world coordinates
-                float world_x = static_cast<float>(cx * CHUNK_SIZE_X + x);
-                float world_z = static_cast<float>(cz * CHUNK_SIZE_Z + z);
-
-                // 1. バイオーム判定用のノイズ
-                float selector_raw = fractal_noise(world_x * 0.002f + offsetX, world_z * 0.002f + offsetZ, 3, 0.5f, 2.0f);
-                float mountain_weight = std::clamp((selector_raw - 0.5f) * 3.3f, 0.0f, 1.0f);
-                float selector = std::clamp((selector_raw - 0.3f) * 2.0f, 0.0f, 1.0f);
-
-                float humidity = fractal_noise(world_x * 0.01f + offsetX, world_z * 0.01f + offsetZ, 2, 0.5f, 2.0f);
-
-                // 2. 地形の高さ計算
-                // 平原・砂漠
-                float lowland_height = fractal_noise(world_x * 0.008f + offsetX, world_z * 0.008f + offsetZ, 3, 0.3f, 2.0f) * 10.0f + 64.0f;
-                // 山岳 (累乗で急傾斜)
-                float mountain_height_raw = fractal_noise(world_x * 0.012f + offsetX, world_z * 0.012f + offsetZ, 5, 0.55f, 2.0f);
-                mountain_height_raw = std::max(0.0f, mountain_height_raw);
-                float mountain_height = std::pow(mountain_height_raw, 2.0f) * 120.0f + 63.0f;
-
-                // 基本地形の合成
-                float original_height = lerp(lowland_height, mountain_height, mountain_weight);
-
-                // 3. 川の計算
-                float river_n = fractal_noise(world_x * 0.005f + offsetX, world_z * 0.005f + offsetZ, 2, 0.5f, 2.0f);
-                float river_v = std::abs(river_n - 0.5f) * 2.0f;
-                float river_mask = std::clamp(river_v / 0.15f, 0.0f, 1.0f);
-
-                // 川の深さ
-                float river_depth = 10.0f * (1.0f - river_mask);
-                original_height -= river_depth;
+                const ColumnShape shape = column_shape(noise, x * CHUNK_SIZE_Z + z);
+                const float mountain_weight = shape.mountain_weight;
+                const float humidity = shape.humidity;
+                const float river_depth = shape.river_depth;
 
                 // blend two heights
-                int terrain_height = static_cast<int>(original_height);
+                int terrain_height = static_cast<int>(shape.height);
                 terrain_height_map[x][z] = terrain_height;
 
                 // 2. Humidity noise
@@ -250,16 +341,115 @@ namespace ocm {
             }
         }
 
-        m_chunks[{cx, cz}] = std::move(chunk);
+        chunk->compact();
+        return chunk;
+    }
+
+    void World::generate_chunk(int cx, int cz) {
+        m_chunks.insert_or_assign(cx, cz, build_chunk(cx, cz));
     }
 
-    void World::generate_world(int width, int depth) {
+    std::vector<uint64_t> World::generate_world(int width, int depth,
+                                                const std::function<void(const GenerationProgress&)>& progress) {
+        width = std::max(0, width);
+        depth = std::max(0, depth);
+        const size_t total = static_cast<size_t>(width) * depth;
+        std::vector<uint64_t> hashes(total, 0);
+
+        // update で依頼済みのチャンクは、ここで作り直すものと混ざらないよう取り消す
+        cancel_generation();
+        if (m_onUnload) {
+            for (auto const& entry : m_chunks) m_onUnload(*entry.chunk);
+        }
         m_chunks.clear();
+        if (total == 0) return hashes;
+
+        // 中心 (スポーン地点) に近い順に依頼する (同じ距離なら z, x の順)
+        struct Request {
+            int cx, cz;
+            int dist2; // 中心からの距離の2乗 (半チャンク単位)
+        };
+        std::vector<Request> requests;
+        requests.reserve(total);
         for (int cz = 0; cz < depth; cz++) {
             for (int cx = 0; cx < width; cx++) {
-                generate_chunk(cx, cz);
+                int dx = cx * 2 + 1 - width;
+                int dz = cz * 2 + 1 - depth;
+                requests.push_back({ cx, cz, dx * dx + dz * dz });
             }
         }
+        std::stable_sort(requests.begin(), requests.end(),
+            [](const Request& a, const Request& b) { return a.dist2 < b.dist2; });
+
+        // ワーカーが完成させたチャンク (呼び出し元が待って受け取る)
+        struct Completed {
+            std::mutex mutex;
+            std::condition_variable ready;
+            std::vector<ChunkPtr> chunks;
+        } completed;
+
+        // build_chunk は (シード, cx, cz) だけで決まり World を変更しないので、どのワーカーがいつ作っても同じ
+        std::vector<util::ThreadPool::Job> jobs;
+        jobs.reserve(total);
+        for (const Request& req : requests) {
+            int cx = req.cx;
+            int cz = req.cz;
+            jobs.push_back({ [this, cx, cz, &completed]() {
+                ChunkPtr chunk = this->build_chunk(cx, cz);
+                // completed は呼び出し元のスタックにあるので、ロックを持ったまま通知する
+                // (先に解放すると、最後のチャンクを受け取った呼び出し元が戻って破棄した後に通知しかねない)
+                std::lock_guard<std::mutex> lock(completed.mutex);
+                completed.chunks.push_back(std::move(chunk));
+                completed.ready.notify_one();
+            }, util::Priority::HIGH, {} });
+        }
+        generation_pool().submit_batch(jobs);
+
+        std::vector<ChunkPtr> ready;
+        size_t done = 0;
+        while (done < total) {
+            {
+                std::unique_lock<std::mutex> lock(completed.mutex);
+                completed.ready.wait(lock, [&] { return !completed.chunks.empty(); });
+                ready.swap(completed.chunks);
+            }
+            for (ChunkPtr& chunk : ready) {
+                int cx = chunk->cx();
+                int cz = chunk->cz();
+                uint64_t hash = chunk->content_hash();
+                hashes[static_cast<size_t>(cz) * width + cx] = hash;
+                insert_chunk(std::move(chunk));
+                done++;
+                if (progress) progress({ cx, cz, hash, done, total });
+            }
+            ready.clear();
+        }
+        return hashes;
+    }
+
+    void World::set_generation_threads(unsigned int threads) {
+        cancel_generation();
+        m_genPool.reset();
+        m_genThreads = threads;
+    }
+
+    util::ThreadPool& World::generation_pool() {
+        if (!m_genPool) {
+            // 描画スレッドの分を1つ空けておく
+            unsigned int threads = m_genThreads;
+            if (threads == 0) {
+                unsigned int hc = std::thread::hardware_concurrency();
+                threads = hc > 1 ? hc - 1 : 1;
+            }
+            m_genPool = std::make_unique<util::ThreadPool>(threads);
+        }
+        return *m_genPool;
+    }
+
+    // update で依頼した生成を全て取り消す (着手済みの結果は publish_generated_chunks で捨てられる)
+    void World::cancel_generation() {
+        for (auto& entry : m_genPending) entry.second.cancel();
+        m_genPending.clear();
     }
 
     BlockID World::get_block(int wx, int wy, int wz) const {
@@ -274,15 +464,14 @@ namespace ocm {
         int lx = wx - (cx * CHUNK_SIZE_X);
         int lz = wz - (cz * CHUNK_SIZE_Z);
 
-        auto it = m_chunks.find({cx, cz});
-        if (it != m_chunks.end()) {
-            return static_cast<BlockID>(it->second->get_block(lx, wy, lz));
+        if (Chunk* chunk = m_chunks.find(cx, cz)) {
+            return static_cast<BlockID>(chunk->get_block(lx, wy, lz));
         }
         return BlockID::AIR;
     }
 
     int World::sample_height(int world_x, int world_z) const {
-        float noise_val = fractal_noise(
+        float noise_val = fractal_noise_2d(
             world_x * 0.03f,
             world_z * 0.03f,
             4,      // octaves
@@ -304,9 +493,9 @@ namespace ocm {
         int total_max_h = 0;
 
         // 全チャンクをループして統計を取る
-        for (auto const& [coords, chunkPtr] : m_chunks) {
-            int cx = coords.first;
-            int cz = coords.second;
+        for (auto const& entry : m_chunks) {
+            int cx = entry.cx();
+            int cz = entry.cz();
 
             int chunk_min_h = CHUNK_SIZE_Y;
             int chunk_max_h = 0;
@@ -329,50 +518,279 @@ namespace ocm {
         }
         std::printf("---------------------------\n");
         std::printf("Global Height Range: [%d - %d]\n", total_min_h, total_max_h);
+        if (m_noiseStep > 0) {
+            // 生成済みの範囲で、粗い格子による地形の高さの誤差
+            int min_cx = 0, max_cx = 0, min_cz = 0, max_cz = 0;
+            bool first = true;
+            for (auto const& entry : m_chunks) {
+                min_cx = first ? entry.cx() : std::min(min_cx, entry.cx());
+                max_cx = first ? entry.cx() : std::max(max_cx, entry.cx());
+                min_cz = first ? entry.cz() : std::min(min_cz, entry.cz());
+                max_cz = first ? entry.cz() : std::max(max_cz, entry.cz());
+                first = false;
+            }
+            SamplingError e = measure_sampling_error(min_cx, min_cz, max_cx - min_cx + 1, max_cz - min_cz + 1);
+            std::printf("Noise Sampling (step %d): height error max %.3f mean %.4f, changed %zu/%zu columns, "
+                        "evaluations %zu -> %zu per chunk\n",
+                        m_noiseStep, e.max_error, e.mean_error, e.changed_columns, e.columns,
+                        e.exact_evaluations * COLUMNS / e.columns, e.sampled_evaluations * COLUMNS / e.columns);
+        }
         std::printf("---------------------------\n");
     }
 
+    SamplingError World::measure_sampling_error(int cx0, int cz0, int width, int depth) const {
+        SamplingError result;
+        ColumnNoise exact, sampled;
+        double sum = 0.0;
+        for (int cz = cz0; cz < cz0 + depth; cz++) {
+            for (int cx = cx0; cx < cx0 + width; cx++) {
+                sample_columns(cx, cz, 0, exact);
+                sample_columns(cx, cz, m_noiseStep, sampled);
+                result.exact_evaluations += exact.evaluations;
+                result.sampled_evaluations += sampled.evaluations;
+
+                for (int i = 0; i < COLUMNS; i++) {
+                    float a = column_shape(exact, i).height;
+                    float b = column_shape(sampled, i).height;
+                    float error = std::abs(a - b);
+                    result.max_error = std::max(result.max_error, error);
+                    sum += error;
+                    if (static_cast<int>(a) != static_cast<int>(b)) result.changed_columns++;
+                    result.columns++;
+                }
+            }
+        }
+        if (result.columns > 0) result.mean_error = static_cast<float>(sum / static_cast<double>(result.columns));
+        return result;
+    }
+
     bool World::has_chunk(int cx, int cz) const {
-        return m_chunks.find({cx, cz}) != m_chunks.end();
+        return m_chunks.contains(cx, cz);
+    }
+
+    void World::insert_chunk(ChunkPtr chunk) {
+        int cx = chunk->cx();
+        int cz = chunk->cz();
+
+        // 置き換えられるチャンクの GPU 側の後始末
+        if (Chunk* old = m_chunks.find(cx, cz)) {
+            if (m_onUnload) m_onUnload(*old);
+        }
+
+        // 新しく生成されたチャンク自身をメッシュの更新対象へ
+        m_chunks.insert_or_assign(cx, cz, std::move(chunk))->set_dirty(true);
+
+        // 隣接する4チャンクがある場合、それらも更新対象へ
+        auto set_neighbor_dirty = [&](int ncx, int ncz) {
+            if (Chunk* neighbor = m_chunks.find(ncx, ncz)) {
+                neighbor->set_dirty(true);
+            }
+        };
+
+        set_neighbor_dirty(cx + 1, cz); // X+
+        set_neighbor_dirty(cx - 1, cz); // X-
+        set_neighbor_dirty(cx, cz + 1); // Z+
+        set_neighbor_dirty(cx, cz - 1); // Z-
+
+        // ワールド全体でメッシュ更新の必要があることを示す
+        m_needsMeshUpdate = true;
+    }
+
+    // ワーカーが完成させたチャンクをワールドへ反映する
+    // update の先頭 (描画スレッドがワールドを読んでいない時点) でのみ呼ぶ
+    void World::publish_generated_chunks() {
+        std::vector<GenResult> results;
+        {
+            std::lock_guard<std::mutex> lock(m_genMutex);
+            results.swap(m_genResults);
+        }
+
+        for (auto& result : results) {
+            auto it = m_genPending.find(ChunkMap::pack_key(result.chunk->cx(), result.chunk->cz()));
+            // 実行中に取り消された依頼の結果 (再依頼済みなら別のトークンが登録されている)
+            if (it == m_genPending.end() || it->second != result.token) continue;
+            m_genPending.erase(it);
+            insert_chunk(std::move(result.chunk));
+        }
+    }
+
+    // 依頼済みで未着手の生成を現在のプレイヤー位置と向きで見直す
+    //   視界 + 猶予より遠い: 取り消し (着手済みでも結果は捨てる)
+    //   正面: HIGH (LOW で待っているものは取り消して、このフレームで HIGH として依頼し直す)
+    //   背後: LOW (キュー内で後ろへ回る)
+    void World::reprioritize_generation(int pCX, int pCZ, float playerX, float playerZ, int viewDistance, float dirX, float dirZ) {
+        const int keepDistance = viewDistance + m_unloadMargin;
+        for (auto it = m_genPending.begin(); it != m_genPending.end();) {
+            int cx = ChunkMap::unpack_x(it->first);
+            int cz = ChunkMap::unpack_z(it->first);
+            const util::CancelToken& token = it->second;
+
+            if (std::abs(cx - pCX) > keepDistance || std::abs(cz - pCZ) > keepDistance) {
+                token.cancel();
+                it = m_genPending.erase(it);
+                continue;
+            }
+
+            float dx = (cx + 0.5f) - playerX / CHUNK_SIZE_X;
+            float dz = (cz + 0.5f) - playerZ / CHUNK_SIZE_Z;
+            float dist = std::sqrt(dx * dx + dz * dz);
+            bool inFront = (dirX == 0.0f && dirZ == 0.0f) || dist < 1.5f || (dx * dirX + dz * dirZ) > 0.5f * dist;
+
+            if (!inFront) {
+                token.set_priority(util::Priority::LOW);
+            } else if (token.priority() == util::Priority::LOW && !token.started()) {
+                token.cancel();
+                it = m_genPending.erase(it);
+                continue;
+            }
+            ++it;
+        }
     }
 
-    void World::update(float playerX, float playerZ, int viewDistance) {
+    void World::update(float playerX, float playerZ, int viewDistance, float dirX, float dirZ) {
+        publish_generated_chunks();
+
         // プレイヤーが今どのチャンクにいるか
         int pCX = static_cast<int>(std::floor(playerX / static_cast<float>(CHUNK_SIZE_X)));
         int pCZ = static_cast<int>(std::floor(playerZ / static_cast<float>(CHUNK_SIZE_Z)));
 
-        // bool chunkGenerated = false;
+        m_frame++;
+        unload_chunks(pCX, pCZ, viewDistance);
+
+        // 視線方向 (水平成分のみ)
+        float dirLen = std::sqrt(dirX * dirX + dirZ * dirZ);
+        if (dirLen > 0.0f) {
+            dirX /= dirLen;
+            dirZ /= dirLen;
+        }
 
-        // プレイヤーの周囲 (viewDistance) のチャンクをチェック
+        reprioritize_generation(pCX, pCZ, playerX, playerZ, viewDistance, dirX, dirZ);
+        if (m_genPending.size() >= MAX_GEN_IN_FLIGHT) return;
+
+        struct Request {
+            int cx, cz;
+            float score; // 小さいほど優先
+            bool inFront;
+        };
+        std::vector<Request> requests;
+
+        // プレイヤーの周囲 (viewDistance) の未生成チャンクを集める
         for (int cz = pCZ - viewDistance; cz <= pCZ + viewDistance; cz++) {
             for (int cx = pCX - viewDistance; cx <= pCX + viewDistance; cx++) {
-                
-                // チャンクが存在しない場合のみ生成処理を行う
-                if (!has_chunk(cx, cz)) {
-                    generate_chunk(cx, cz);
-                    // std::printf("[World] Generated chunk (%d, %d)\n", cx, cz);
-
-                    // 新しく生成されたチャンク自身をメッシュの更新対象へ
-                    m_chunks[{cx, cz}]->set_dirty(true);
-
-                    // 隣接する4チャンクがある場合、それらも更新対象へ
-                    auto set_neighbor_dirty = [&](int ncx, int ncz) {
-                        auto it = m_chunks.find({ncx, ncz});
-                        if (it != m_chunks.end()) {
-                            it->second->set_dirty(true);
-                        }
-                    };
+                if (has_chunk(cx, cz) || m_genPending.count(ChunkMap::pack_key(cx, cz))) continue;
 
-                    set_neighbor_dirty(cx + 1, cz); // X+
-                    set_neighbor_dirty(cx - 1, cz); // X-
-                    set_neighbor_dirty(cx, cz + 1); // Z+
-                    set_neighbor_dirty(cx, cz - 1); // Z-
+                // プレイヤーからチャンク中心への距離 (チャンク単位)
+                float dx = (cx + 0.5f) - playerX / CHUNK_SIZE_X;
+                float dz = (cz + 0.5f) - playerZ / CHUNK_SIZE_Z;
+                float dist = std::sqrt(dx * dx + dz * dz);
 
-                    // ワールド全体でメッシュ更新の必要があることを示す
-                    m_needsMeshUpdate = true;
-                }
+                // 視線方向の前方 (約 ±60°) にあるチャンクを優先し、背後のものは viewDistance 分遅らせる
+                bool inFront = dirLen == 0.0f || dist < 1.5f || (dx * dirX + dz * dirZ) > 0.5f * dist;
+                float score = dist + (inFront ? 0.0f : static_cast<float>(viewDistance));
+                requests.push_back({ cx, cz, score, inFront });
             }
         }
+
+        // 優先度の高いものから、同時依頼数の上限まで発行する
+        // 残りは次のフレームにプレイヤー位置と向きで並べ替え直す
+        size_t budget = MAX_GEN_IN_FLIGHT - m_genPending.size();
+        if (requests.size() > budget) {
+            std::partial_sort(requests.begin(), requests.begin() + budget, requests.end(),
+                [](const Request& a, const Request& b) { return a.score < b.score; });
+            requests.resize(budget);
+        } else {
+            std::sort(requests.begin(), requests.end(),
+                [](const Request& a, const Request& b) { return a.score < b.score; });
+        }
+
+        // 正面のものは HIGH、背後のものは LOW で依頼する (キュー内でも正面が先に実行される)
+        std::vector<util::ThreadPool::Job> jobs;
+        jobs.reserve(requests.size());
+        for (const Request& req : requests) {
+            util::Priority priority = req.inFront ? util::Priority::HIGH : util::Priority::LOW;
+            util::CancelToken token = util::CancelToken::create(priority);
+            m_genPending.emplace(ChunkMap::pack_key(req.cx, req.cz), token);
+            int cx = req.cx;
+            int cz = req.cz;
+            jobs.push_back({ [this, cx, cz, token]() {
+                ChunkPtr chunk = this->build_chunk(cx, cz);
+
+                std::lock_guard<std::mutex> lock(this->m_genMutex);
+                this->m_genResults.push_back({ std::move(chunk), token });
+            }, priority, token });
+        }
+        generation_pool().submit_batch(jobs);
+    }
+
+    void World::set_residency(int hysteresis, size_t memoryBudget) {
+        m_unloadMargin = std::max(0, hysteresis);
+        m_memoryBudget = memoryBudget;
+    }
+
+    ResidencyStats World::residency_stats() const {
+        ResidencyStats stats;
+        stats.resident_chunks = m_chunks.size();
+        for (auto const& entry : m_chunks) {
+            stats.block_bytes += entry.chunk->memory_bytes();
+            stats.gpu_bytes += entry.chunk->gpu_bytes;
+        }
+        stats.unloaded_total = m_unloadedTotal;
+        return stats;
+    }
+
+    // メッシュ構築中のチャンクは、結果が戻るまで解放を見送る
+    // (ワーカーはスナップショットしか読まないが、構築中に解放すると計算が無駄になる)
+    bool World::is_chunk_busy(int cx, int cz) const {
+        Chunk* chunk = m_chunks.find(cx, cz);
+        return chunk && chunk->is_meshing;
+    }
+
+    void World::unload_chunks(int pCX, int pCZ, int viewDistance) {
+        struct Candidate {
+            int cx, cz;
+            int dist;
+            uint64_t lastVisible;
+            size_t bytes;
+        };
+        std::vector<Candidate> far;      // 距離で必ずアンロードするもの
+        std::vector<Candidate> outside;  // 視界外だが猶予範囲内のもの (予算超過時のみ)
+        size_t totalBytes = 0;
+
+        for (auto const& entry : m_chunks) {
+            const Chunk& chunk = *entry.chunk;
+            size_t bytes = chunk.memory_bytes() + chunk.gpu_bytes;
+            totalBytes += bytes;
+
+            int dist = std::max(std::abs(entry.cx() - pCX), std::abs(entry.cz() - pCZ));
+            if (dist <= viewDistance) continue;
+
+            Candidate c{ entry.cx(), entry.cz(), dist, chunk.last_visible_frame, bytes };
+            if (dist > viewDistance + m_unloadMargin) far.push_back(c);
+            else outside.push_back(c);
+        }
+
+        auto unload = [&](const Candidate& c) {
+            if (is_chunk_busy(c.cx, c.cz)) return false;
+            if (m_onUnload) m_onUnload(*m_chunks.find(c.cx, c.cz));
+            m_chunks.erase(c.cx, c.cz);
+            totalBytes -= c.bytes;
+            m_unloadedTotal++;
+            return true;
+        };
+
+        for (const Candidate& c : far) unload(c);
+        if (totalBytes <= m_memoryBudget) return;
+
+        // 予算超過: 長く描画されていないもの、同じなら遠いものから追い出す
+        // 視界内 (viewDistance 以内) のチャンクは追い出さない
+        std::sort(outside.begin(), outside.end(), [](const Candidate& a, const Candidate& b) {
+            if (a.lastVisible != b.lastVisible) return a.lastVisible < b.lastVisible;
+            return a.dist > b.dist;
+        });
+        for (const Candidate& c : outside) {
+            if (totalBytes <= m_memoryBudget) break;
+            unload(c);
+        }
     }
 
     std::vector<Chunk*> World::get_visible_chunks(const glm::vec3& camPos, int viewDistance) {
@@ -383,9 +801,9 @@ namespace ocm {
 
         for (int cz = pCZ - viewDistance; cz <= pCZ + viewDistance; cz++) {
             for (int cx = pCX - viewDistance; cx <= pCX + viewDistance; cx++) {
-                auto it = m_chunks.find({cx, cz});
-                if (it != m_chunks.end()) {
-                    visibleChunks.push_back(it->second.get());
+                if (Chunk* chunk = m_chunks.find(cx, cz)) {
+                    chunk->last_visible_frame = m_frame;
+                    visibleChunks.push_back(chunk);
                 }
             }
         }
@@ -393,30 +811,19 @@ namespace ocm {
     }
 
     Chunk* World::get_chunk_ptr(int cx, int cz) const {
-        auto it = m_chunks.find({cx, cz});
-        if (it != m_chunks.end()) {
-            return it->second.get();
-        }
-        return nullptr;
+        return m_chunks.find(cx, cz);
     }
 
     std::vector<Chunk*> World::get_all_chunks_raw_ptr() const {
         std::vector<Chunk*> ptrs;
         ptrs.reserve(m_chunks.size());
-        for (auto const& [coords, chunk] : m_chunks) {
-            ptrs.push_back(chunk.get());
+        for (auto const& entry : m_chunks) {
+            ptrs.push_back(entry.chunk.get());
         }
         return ptrs;
     }
 
     bool World::is_opaque(int wx, int wy, int wz) const {
-        BlockID id = get_block(wx, wy, wz);
-        if (id == BlockID::AIR || 
-            id == BlockID::WATER || 
-            id == BlockID::CACTUS ||
-            id == BlockID::LEAVES) {
-            return false;
-        }
-        return true;
+        return is_opaque_id(get_block(wx, wy, wz));
     }
 } // namespace ocm
\ No newline at end of file
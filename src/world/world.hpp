@@ -3,15 +3,45 @@
 #include <cstdint>
 #include <memory>
 #include <vector>
-#include <map>
 #include <optional>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
 #include "../block/block.hpp"
+#include "../util/thread_pool.hpp"
 #include "chunk.hpp"
+#include "chunk_map.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 namespace ocm {
+    // 粗い格子でノイズを計算したときの地形の高さの誤差 (World::measure_sampling_error)
+    struct SamplingError {
+        size_t columns = 0;
+        float max_error = 0.0f;       // 補間前の高さ (ブロック単位) の差の最大
+        float mean_error = 0.0f;      // 同じく平均
+        size_t changed_columns = 0;   // 整数の地形の高さが変わったカラム数
+        size_t exact_evaluations = 0; // 全カラムで厳密に計算したときの perlin_noise_2d の呼び出し回数
+        size_t sampled_evaluations = 0;
+    };
+
+    // World::generate_world の進捗 (チャンクを1つワールドへ反映するたびに通知する)
+    struct GenerationProgress {
+        int cx, cz;
+        uint64_t hash; // Chunk::content_hash
+        size_t done;   // 反映済みのチャンク数 (このチャンクを含む)
+        size_t total;
+    };
+
+    // 常駐チャンクの統計
+    struct ResidencyStats {
+        size_t resident_chunks = 0;
+        size_t block_bytes = 0;    // ブロックデータ (CPU)
+        size_t gpu_bytes = 0;      // メッシュ (GPU)
+        size_t unloaded_total = 0; // これまでにアンロードしたチャンク数
+    };
+
     class World {
         public:
             World();
@@ -26,29 +56,112 @@ namespace ocm {
             float grad(int hash, float x, float y, float z) const;
             float perlin_noise(float x, float y, float z) const;
             float fractal_noise(float x, float z, int octaves, float persistence, float lacunarity) const;
+            // 高さマップなど水平面だけで決まる層用 (3D 版を y 固定で呼ぶより軽い)
+            float perlin_noise_2d(float x, float z) const;
+            float fractal_noise_2d(float x, float z, int octaves, float persistence, float lacunarity) const;
             
-            float get_noise_random(int x, int z);
+            float get_noise_random(int x, int z) const;
+            // ブロックデータのみを生成して返す (World の状態を変更しないのでワーカースレッドから呼べる)
+            ChunkPtr build_chunk(int cx, int cz) const;
             void generate_chunk(int cx, int cz);
-            void generate_world(int width, int depth);
+            // チャンク [0, width) x [0, depth) をワーカースレッドで並列に生成して置き換える
+            // 中心に近いチャンクから依頼し、完成したものから呼び出し元のスレッドでワールドへ反映して progress を呼ぶ
+            // (progress の中でワールドを描画してよい)。全て反映し終えてから戻る
+            // 戻り値は各チャンクの content_hash ([cz * width + cx])。ブロックはスレッド数や完成順によらず同じになる
+            std::vector<uint64_t> generate_world(int width, int depth,
+                                                 const std::function<void(const GenerationProgress&)>& progress = {});
+            // 生成に使うワーカースレッド数 (0 なら hardware_concurrency - 1)
+            // 生成中の依頼は取り消すので、生成を始める前に呼ぶ
+            void set_generation_threads(unsigned int threads);
             BlockID get_block(int wx, int wy, int wz) const;
             
             int sample_height(int world_x, int world_z) const;
             void dump_stats() const;
 
+            // 波長が格子間隔の NOISE_LATTICE_WAVELENGTHS 倍以上あるオクターブを step ブロックおきの格子点でだけ計算し、
+            // 間のカラムは双線形補間する (それより細かいオクターブは全カラムで計算する)
+            // step は CHUNK_SIZE_X の約数 (2, 4, 8, 16)。0 や 1 なら全て厳密に計算する
+            // 生成中のワーカーも読むので、チャンクの生成を始める前に呼ぶ
+            void set_noise_sampling(int step);
+            int noise_sampling() const noexcept { return m_noiseStep; }
+            // チャンク [cx0, cx0 + width) x [cz0, cz0 + depth) の全カラムについて、
+            // 現在の step と厳密な計算とで地形の高さを比べる (ワールドは変更しない)
+            SamplingError measure_sampling_error(int cx0, int cz0, int width, int depth) const;
+
             bool has_chunk(int cx, int cz) const;
             bool m_needsMeshUpdate = false; // メッシュ更新が必要かどうか
-            void update(float playerX, float playerZ, int viewDistance);
+            // 視界内の未生成チャンクをワーカースレッドへ依頼し、完成したものをワールドへ反映する
+            // (dirX, dirZ) はカメラの向き。正面のチャンクから優先して生成する
+            void update(float playerX, float playerZ, int viewDistance, float dirX = 0.0f, float dirZ = 0.0f);
+            size_t pending_chunk_count() const noexcept { return m_genPending.size(); }
+
+            // viewDistance + hysteresis より遠いチャンクはアンロードする
+            // さらに常駐量が memoryBudget (ブロックデータ + GPUメッシュ) を超えた場合は、
+            // 視界外のチャンクを「長く描画されていない順・遠い順」に追い出す
+            void set_residency(int hysteresis, size_t memoryBudget);
+            ResidencyStats residency_stats() const;
+            // チャンクをアンロード (または同じ位置に作り直して置き換え) する直前に呼ばれる
+            // GPU 上のメッシュはチャンクが持たないので、描画側はここで返却する
+            // (destroy では呼ばない: 描画側がワールドより先に破棄されるため)
+            void set_unload_callback(std::function<void(Chunk&)> callback) { m_onUnload = std::move(callback); }
 
             std::vector<Chunk*> get_visible_chunks(const glm::vec3& camPos, int viewDistance);
             Chunk* get_chunk_ptr(int cx, int cz) const;
             std::vector<Chunk*> get_all_chunks_raw_ptr() const;
 
             bool is_opaque(int wx, int wy, int wz) const;
+            static bool is_opaque_id(BlockID id) { return block_info(id).opaque; }
     
         private:
             uint32_t m_seed = 0;
-            std::map<std::pair<int, int>, ChunkPtr> m_chunks;
+            ChunkMap m_chunks;
             // Permutation table for Perlin noise
             std::vector<int> p;
+
+            // 地形生成のノイズ
+            static constexpr int NOISE_LATTICE_WAVELENGTHS = 4;
+            int m_noiseStep = 4;
+            static constexpr int COLUMNS = CHUNK_SIZE_X * CHUNK_SIZE_Z;
+            // チャンクの全カラム分の各層 (カラム i = x * CHUNK_SIZE_Z + z)
+            struct ColumnNoise {
+                float selector[COLUMNS], humidity[COLUMNS], lowland[COLUMNS], mountain[COLUMNS], river[COLUMNS];
+                size_t evaluations = 0; // perlin_noise_2d の呼び出し回数
+            };
+            // カラムの地形 (ノイズの層から求めたもの)
+            struct ColumnShape {
+                float height; // 整数に切り捨てる前の地形の高さ
+                float mountain_weight;
+                float humidity;
+                float river_depth;
+            };
+            void sample_columns(int cx, int cz, int step, ColumnNoise& out) const;
+            ColumnShape column_shape(const ColumnNoise& noise, int column) const;
+
+            // 非同期チャンク生成
+            static constexpr size_t MAX_GEN_IN_FLIGHT = 32; // 同時に依頼する最大数 (残りは毎フレーム並べ替えて再評価)
+            std::unique_ptr<util::ThreadPool> m_genPool;
+            unsigned int m_genThreads = 0;
+            struct GenResult {
+                ChunkPtr chunk;
+                util::CancelToken token; // 依頼時のトークン (取り消し・再依頼された結果は捨てる)
+            };
+            std::unordered_map<uint64_t, util::CancelToken> m_genPending; // 依頼済みで未反映のチャンク
+            std::vector<GenResult> m_genResults;                          // ワーカーが完成させたチャンク
+            std::mutex m_genMutex;                                        // m_genResults の排他制御
+
+            // 常駐ポリシー
+            int m_unloadMargin = 2;
+            size_t m_memoryBudget = size_t(512) << 20;
+            uint64_t m_frame = 0;
+            size_t m_unloadedTotal = 0;
+            std::function<void(Chunk&)> m_onUnload;
+
+            util::ThreadPool& generation_pool();
+            void cancel_generation();
+            void publish_generated_chunks();
+            void reprioritize_generation(int pCX, int pCZ, float playerX, float playerZ, int viewDistance, float dirX, float dirZ);
+            void insert_chunk(ChunkPtr chunk);
+            void unload_chunks(int pCX, int pCZ, int viewDistance);
+            bool is_chunk_busy(int cx, int cz) const;
     };
 } // namespace ocm
\ No newline at end of file
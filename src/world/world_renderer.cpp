@@ -1,12 +1,67 @@
 #include "world_renderer.hpp"
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
 #include <future>
+#include <utility>
 namespace ocm {
+    // BlockClass の各値について f(std::integral_constant<int, c>) を呼ぶ
+    // (分類の表引きがコンパイル時に畳み込まれ、ループも残らない)
+    template <typename F, int... C>
+    static inline void for_each_class(F&& f, std::integer_sequence<int, C...>) {
+        (f(std::integral_constant<int, C>{}), ...);
+    }
+    template <typename F>
+    static inline void for_each_class(F&& f) {
+        for_each_class(f, std::make_integer_sequence<int, static_cast<int>(BlockClass::COUNT)>{});
+    }
+
+    // 四角形を所属するセクション (4頂点の実際の y を切り捨てた値の最小) の順に安定に並べ替え、区間の境界を sections に返す
+    // 上面は上のセクション側に入るが、そのセクションの箱の境界上にあるのでカリングの判定は変わらない
+    // lower の頂点 (y - VERTEX_LOWER) は1つ下の段として数える。下げた水面 (y = 64 なら 63.9) は下のセクションの箱の中にある
+    static void sort_quads_by_section(std::vector<gfx::PackedVertex>& vertices, std::vector<uint32_t>& sections) {
+        size_t quads = vertices.size() / 4;
+        std::vector<uint8_t> owner(quads);
+        sections.assign(SECTION_COUNT + 1, 0);
+        for (size_t q = 0; q < quads; q++) {
+            uint32_t y = 255;
+            for (int k = 0; k < 4; k++) {
+                uint32_t lo = vertices[q * 4 + k].lo;
+                uint32_t vy = (lo >> 5) & 255;
+                uint32_t lower = (lo >> 21) & 1;
+                y = std::min(y, vy >= lower ? vy - lower : 0u);
+            }
+            owner[q] = static_cast<uint8_t>(std::min<uint32_t>(y / SECTION_SIZE, SECTION_COUNT - 1));
+            sections[owner[q] + 1]++;
+        }
+        for (int s = 0; s < SECTION_COUNT; s++) sections[s + 1] += sections[s];
+
+        std::vector<gfx::PackedVertex> sorted(vertices.size());
+        std::array<uint32_t, SECTION_COUNT> next;
+        std::copy_n(sections.begin(), SECTION_COUNT, next.begin());
+        for (size_t q = 0; q < quads; q++) {
+            std::copy_n(&vertices[q * 4], 4, &sorted[next[owner[q]]++ * 4]);
+        }
+        vertices.swap(sorted);
+    }
+
+    // チャンクの中心がカメラの前方 (半チャンク分の余裕込み) にあるか
+    static bool is_in_front(const glm::mat4& viewProj, const Chunk& chunk) {
+        glm::vec4 center((chunk.cx() + 0.5f) * CHUNK_SIZE_X, CHUNK_SIZE_Y * 0.5f, (chunk.cz() + 0.5f) * CHUNK_SIZE_Z, 1.0f);
+        return (viewProj * center).w > -static_cast<float>(CHUNK_SIZE_X);
+    }
+
     WorldRenderer::WorldRenderer() {
         m_pool = std::make_unique<util::ThreadPool>(std::thread::hardware_concurrency());
     }
-    WorldRenderer::~WorldRenderer() = default;
+    WorldRenderer::~WorldRenderer() {
+        // 結果の待ち行列で待っているワーカーを解放してから、プールを先に止める
+        for (auto& job : m_meshJobs) job.second.token.cancel();
+        m_pool.reset();
+    }
 
     bool WorldRenderer::init() {
         return m_cubeRenderer.init();
@@ -16,7 +71,13 @@ namespace ocm {
         // 描画対象のチャンクを取得
         std::vector<Chunk*> visibleChunks = const_cast<World&>(world).get_visible_chunks(camPos, viewDistance);
         // メッシュの非同期更新リクエストと結果の回収
-        update_meshes(const_cast<World&>(world));
+        update_meshes(world, camPos, viewProj, viewDistance);
+        // カメラのセクションから辿れないセクションと、視錐台の外のチャンク・セクションを除く
+        // (転送の後に行い、今フレームの区間とつながりで判定する)
+        trace_reachable_sections(world, camPos, viewDistance);
+        m_viewProj = viewProj;
+        std::vector<uint8_t> visibleSections;
+        cull_chunks(gfx::Frustum(viewProj), visibleChunks, visibleSections);
         // シェーダのグローバル設定
         m_cubeRenderer.setup_frame(glm::value_ptr(viewProj), camPos);
 
@@ -25,12 +86,8 @@ namespace ocm {
         glDepthMask(GL_TRUE);
         glEnable(GL_DEPTH_TEST);
 
-        for (Chunk* chunk : visibleChunks) {
-            // VAOが作成されていない(一度もメッシュ計算が終わっていない)チャンクはスキップ
-            if (chunk->vao != 0 || chunk->indexCount != 0) {
-                m_cubeRenderer.draw_chunk(*chunk);
-            }
-        }
+        // メッシュが未転送のチャンクは描画コマンドを作る時点で飛ばす
+        m_cubeRenderer.draw_chunks(visibleChunks, visibleSections);
 
         // 2. 半透明ブロック
         glEnable(GL_BLEND);
@@ -38,146 +95,595 @@ namespace ocm {
         // 水同士の重なりで消えないよう、深層書き込みを無効化
         glDepthMask(GL_FALSE);
 
-        for (Chunk* chunk : visibleChunks) {
-            if (chunk->trans_vao != 0 || chunk->trans_indexCount != 0) {
-                m_cubeRenderer.draw_chunk_transparent(*chunk);
-            }
-        }
+        m_cubeRenderer.draw_chunks_transparent(visibleChunks, visibleSections);
 
         glDepthMask(GL_TRUE);
         glDisable(GL_BLEND);
     }
 
-    void WorldRenderer::update_meshes(const World& world) {
+    void WorldRenderer::cull_chunks(const gfx::Frustum& frustum, std::vector<Chunk*>& chunks, std::vector<uint8_t>& sections) {
+        m_cullStats = CullStats();
+        sections.clear();
 
-        // メッシュ更新が必要なチャンクを探して更新
-        std::queue<gfx::MeshData> resultsToUpload;
-        {
-            std::lock_guard<std::mutex> lock(m_resultMutex);
-            while (!m_meshResults.empty()) {
-                resultsToUpload.push(std::move(m_meshResults.front()));
-                m_meshResults.pop();
+        gfx::AABB boxes[SECTION_COUNT];
+        size_t kept = 0;
+        m_occluders.clear();
+        for (Chunk* chunk : chunks) {
+            uint8_t meshed = chunk->mesh_sections;
+            if (meshed == 0) continue;
+            m_cullStats.chunks++;
+            m_cullStats.sections += __builtin_popcount(meshed);
+
+            // まずチャンク全体で判定し、境界をまたぐときだけセクションごとに判定する
+            float x0 = static_cast<float>(chunk->cx() * CHUNK_SIZE_X);
+            float z0 = static_cast<float>(chunk->cz() * CHUNK_SIZE_Z);
+            gfx::AABB box{ glm::vec3(x0, 0.0f, z0), glm::vec3(x0 + CHUNK_SIZE_X, static_cast<float>(CHUNK_SIZE_Y), z0 + CHUNK_SIZE_Z) };
+            // 下から詰まった区画は遮蔽物として深度バッファへ描く (描画しないチャンクでも前のものを隠す)
+            if (m_depthOcclusion) {
+                for (int cell = 0; cell < SOLID_CELLS * SOLID_CELLS; cell++) {
+                    if (chunk->solid_heights[cell] == 0) continue;
+                    float ox = x0 + static_cast<float>((cell % SOLID_CELLS) * SOLID_CELL_SIZE);
+                    float oz = z0 + static_cast<float>((cell / SOLID_CELLS) * SOLID_CELL_SIZE);
+                    gfx::AABB slab{ glm::vec3(ox, 0.0f, oz),
+                                    glm::vec3(ox + SOLID_CELL_SIZE, static_cast<float>(chunk->solid_heights[cell]), oz + SOLID_CELL_SIZE) };
+                    if (frustum.intersects(slab)) m_occluders.push_back(slab);
+                }
             }
+
+            uint8_t visible = 0;
+            switch (frustum.classify(box)) {
+                case gfx::Frustum::Result::INSIDE: visible = meshed; break;
+                case gfx::Frustum::Result::OUTSIDE: visible = 0; break;
+                case gfx::Frustum::Result::INTERSECT:
+                    for (int s = 0; s < SECTION_COUNT; s++) {
+                        boxes[s].min = glm::vec3(x0, static_cast<float>(s * SECTION_SIZE), z0);
+                        boxes[s].max = glm::vec3(x0 + CHUNK_SIZE_X, static_cast<float>((s + 1) * SECTION_SIZE), z0 + CHUNK_SIZE_Z);
+                    }
+                    visible = static_cast<uint8_t>(frustum.test_boxes(boxes, SECTION_COUNT)) & meshed;
+                    break;
+            }
+
+            // 視錐台の内にあっても、カメラから辿れないセクションは描画しない
+            if (m_occlusionCulling && m_reachOrigin.valid) {
+                int gx = chunk->cx() - m_reachOrigin.cx + m_reachOrigin.radius;
+                int gz = chunk->cz() - m_reachOrigin.cz + m_reachOrigin.radius;
+                int side = 2 * m_reachOrigin.radius + 1;
+                uint8_t reachable = (gx >= 0 && gx < side && gz >= 0 && gz < side) ? m_reachable[gz * side + gx] : 0;
+                m_cullStats.sections_occluded += __builtin_popcount(visible & ~reachable);
+                visible &= reachable;
+            }
+
+            m_cullStats.sections_culled += __builtin_popcount(meshed & ~visible);
+            if (visible == 0) {
+                m_cullStats.chunks_culled++;
+                continue;
+            }
+            chunks[kept++] = chunk;
+            sections.push_back(visible);
         }
-        
-        while (!resultsToUpload.empty()) {
-            auto& data = resultsToUpload.front();
-            Chunk* chunk = world.get_chunk_ptr(data.cx, data.cz);
-            if (chunk) {
-                m_cubeRenderer.update_chunk_mesh(*chunk, data);
+        chunks.resize(kept);
+
+        if (m_depthOcclusion && !m_occluders.empty()) cull_hidden_sections(chunks, sections);
+    }
+
+    void WorldRenderer::cull_hidden_sections(std::vector<Chunk*>& chunks, std::vector<uint8_t>& sections) {
+        m_occlusionBuffer.clear(m_viewProj);
+        for (const gfx::AABB& box : m_occluders) m_occlusionBuffer.draw_occluder(box);
+        m_occlusionBuffer.build_pyramid();
+        m_cullStats.occluders = static_cast<uint32_t>(m_occluders.size());
+
+        size_t kept = 0;
+        for (size_t i = 0; i < chunks.size(); i++) {
+            Chunk* chunk = chunks[i];
+            float x0 = static_cast<float>(chunk->cx() * CHUNK_SIZE_X);
+            float z0 = static_cast<float>(chunk->cz() * CHUNK_SIZE_Z);
+            uint8_t visible = sections[i];
+            for (int s = 0; s < SECTION_COUNT; s++) {
+                if (!(visible & (1u << s))) continue;
+                gfx::AABB box{ glm::vec3(x0, static_cast<float>(s * SECTION_SIZE), z0),
+                               glm::vec3(x0 + CHUNK_SIZE_X, static_cast<float>((s + 1) * SECTION_SIZE), z0 + CHUNK_SIZE_Z) };
+                if (m_occlusionBuffer.is_occluded(box)) visible &= static_cast<uint8_t>(~(1u << s));
+            }
+
+            int hidden = __builtin_popcount(sections[i] & ~visible);
+            m_cullStats.sections_hidden += hidden;
+            m_cullStats.sections_culled += hidden;
+            if (visible == 0) {
+                m_cullStats.chunks_culled++;
+                continue;
+            }
+            chunks[kept] = chunk;
+            sections[kept] = visible;
+            kept++;
+        }
+        chunks.resize(kept);
+        sections.resize(kept);
+    }
+
+    void WorldRenderer::trace_reachable_sections(const World& world, const glm::vec3& camPos, int viewDistance) {
+        m_reachOrigin.valid = false;
+        if (!m_occlusionCulling) return;
+
+        int pCX = static_cast<int>(std::floor(camPos.x / static_cast<float>(CHUNK_SIZE_X)));
+        int pCZ = static_cast<int>(std::floor(camPos.z / static_cast<float>(CHUNK_SIZE_Z)));
+        int pSY = static_cast<int>(std::floor(camPos.y / static_cast<float>(SECTION_SIZE)));
+        // カメラがワールドの上下の外・未生成のチャンクにいるときは探索の起点がないので、全て辿れるものとする
+        if (pSY < 0 || pSY >= SECTION_COUNT || !world.get_chunk_ptr(pCX, pCZ)) return;
+
+        const int side = 2 * viewDistance + 1;
+        m_reachable.assign(static_cast<size_t>(side) * side, 0);
+        m_reachOrigin = { pCX, pCZ, viewDistance, true };
+
+        // 辿ってきた向きを覚え、その逆向きには進まない (カメラから遠ざかる向きだけに広げる)
+        struct Node {
+            int cx, sy, cz;
+            int entry;        // 入ってきた面 (-1: カメラのセクション)
+            uint8_t traveled; // これまでに進んだ向き (FaceDirection のビット)
+        };
+        static const int STEP[6][3] = {
+            { 0, 0, 1 }, { 0, 0, -1 }, // SIDE_FRONT, SIDE_BACK
+            { 0, 1, 0 }, { 0, -1, 0 }, // TOP, BOTTOM
+            { 1, 0, 0 }, { -1, 0, 0 }, // SIDE_RIGHT, SIDE_LEFT
+        };
+
+        std::vector<Node> queue;
+        queue.push_back({ pCX, pSY, pCZ, -1, 0 });
+        m_reachable[viewDistance * side + viewDistance] |= static_cast<uint8_t>(1u << pSY);
+        for (size_t head = 0; head < queue.size(); head++) {
+            Node node = queue[head];
+            Chunk* chunk = world.get_chunk_ptr(node.cx, node.cz);
+            FaceConnectivity connectivity = chunk->section_connectivity[node.sy];
+
+            for (int d = 0; d < 6; d++) {
+                if (node.traveled & (1u << opposite_face(d))) continue;
+                if (node.entry >= 0 && !faces_connected(connectivity, node.entry, d)) continue;
+
+                int nx = node.cx + STEP[d][0], ny = node.sy + STEP[d][1], nz = node.cz + STEP[d][2];
+                if (ny < 0 || ny >= SECTION_COUNT) continue;
+                if (std::abs(nx - pCX) > viewDistance || std::abs(nz - pCZ) > viewDistance) continue;
+                uint8_t& mask = m_reachable[(nz - pCZ + viewDistance) * side + (nx - pCX + viewDistance)];
+                if (mask & (1u << ny)) continue;
+                if (!world.get_chunk_ptr(nx, nz)) continue;
+
+                mask |= static_cast<uint8_t>(1u << ny);
+                queue.push_back({ nx, ny, nz, opposite_face(d), static_cast<uint8_t>(node.traveled | (1u << d)) });
+            }
+        }
+    }
+
+    void WorldRenderer::release_chunk(Chunk& chunk) {
+        m_cubeRenderer.release_chunk_mesh(chunk);
+    }
+
+    void WorldRenderer::update_meshes(const World& world, const glm::vec3& camPos, const glm::mat4& viewProj, int viewDistance) {
+        int pCX = static_cast<int>(std::floor(camPos.x / static_cast<float>(CHUNK_SIZE_X)));
+        int pCZ = static_cast<int>(std::floor(camPos.z / static_cast<float>(CHUNK_SIZE_Z)));
+        auto in_view = [&](const Chunk& chunk) {
+            return std::abs(chunk.cx() - pCX) <= viewDistance && std::abs(chunk.cz() - pCZ) <= viewDistance;
+        };
+
+        // 完成したメッシュを回収する (ワーカーを待たない)
+        // 転送が済むまでチャンクは is_meshing のままにして、二重に依頼しないようにする
+        MeshResult result;
+        while (m_meshResults.try_pop(result)) {
+            auto it = m_meshJobs.find(ChunkMap::pack_key(result.data.cx, result.data.cz));
+            // 実行中に取り消された依頼の結果 (再依頼済みなら別のトークンが登録されている)
+            if (it == m_meshJobs.end() || it->second.token != result.token) {
+                m_meshStats.wasted++;
+                continue;
+            }
+            m_meshJobs.erase(it);
+            m_pendingUploads.push_back(std::move(result.data));
+        }
+        upload_pending_meshes(world, camPos, viewDistance);
+        m_cubeRenderer.compact_step();
+
+        // 依頼中のものを見直す
+        //   チャンクが消えた: 取り消し
+        //   視界外へ出て未着手: 取り消して Dirty に戻す (視界に戻ったら依頼し直す)
+        //   背後: LOW へ下げる (キュー内で後ろへ回る)
+        //   前方に来た LOW で未着手: 取り消して、下で HIGH として依頼し直す
+        //   依頼後にチャンクが変更されて未着手: 取り消して、下で最新の内容で依頼し直す
+        for (auto it = m_meshJobs.begin(); it != m_meshJobs.end();) {
+            const util::CancelToken& token = it->second.token;
+            Chunk* chunk = world.get_chunk_ptr(ChunkMap::unpack_x(it->first), ChunkMap::unpack_z(it->first));
+            if (!chunk) {
+                token.cancel();
+                it = m_meshJobs.erase(it);
+                continue;
+            }
+
+            bool front = is_in_front(viewProj, *chunk);
+            bool requeue = !token.started()
+                && (!in_view(*chunk) || (front && token.priority() == util::Priority::LOW) || it->second.version != chunk->version);
+            if (requeue) {
+                token.cancel();
+                chunk->is_dirty = true;
                 chunk->is_meshing = false;
+                it = m_meshJobs.erase(it);
+                continue;
             }
-            resultsToUpload.pop();
+            if (!front) token.set_priority(util::Priority::LOW);
+            ++it;
         }
         
-        // 新しいタスクの発行
+        // 新しいタスクの発行 (まとめて投入する)
+        // 描画しない視界外のチャンクは、視界に入るまで Dirty のまま残す
+        // 依頼中の数は結果キューの容量まで (超えた分は次のフレームに回す)
+        std::vector<util::ThreadPool::Job> jobs;
         for (auto* chunk : world.get_all_chunks_raw_ptr()) {
-            if (chunk->is_dirty && !chunk->is_meshing) {
+            if (m_meshJobs.size() >= MESH_RESULT_CAPACITY) break;
+            if (chunk->is_dirty && !chunk->is_meshing && in_view(*chunk)) {
                 chunk->is_dirty = false;
                 chunk->is_meshing = true;
 
-                int cx = chunk->cx();
-                int cz = chunk->cz();
+                // ワーカーに渡すデータはここで複製しておく (ワーカーは World を参照しない)
+                auto snapshot = std::make_shared<ChunkSnapshot>();
+                snapshot->capture(world, chunk->cx(), chunk->cz());
 
-                m_pool->enqueue([this, &world, cx, cz]() {
-                    gfx::MeshData result = this->build_mesh_data(world, cx, cz);
+                util::Priority priority = is_in_front(viewProj, *chunk) ? util::Priority::HIGH : util::Priority::LOW;
+                util::CancelToken token = util::CancelToken::create(priority);
+                // 同じ位置の古い依頼 (アンロード前のチャンク) が残っていれば取り消す
+                MeshJob& slot = m_meshJobs[ChunkMap::pack_key(chunk->cx(), chunk->cz())];
+                slot.token.cancel();
+                slot = { token, snapshot->version };
 
-                    // 結果を安全に格納
-                    std::lock_guard<std::mutex> lock(this->m_resultMutex);
-                    this->m_meshResults.push(std::move(result));
-                });
+                MeshMode mode = m_meshMode;
+                jobs.push_back({ [this, snapshot, mode, token]() {
+                    MeshResult result{ this->build_mesh_data(*snapshot, mode), token };
+
+                    // 取り消された依頼の結果は描画スレッドが捨てるので、満杯なら待たずに諦める
+                    while (!this->m_meshResults.try_push(std::move(result))) {
+                        if (token.cancelled()) return;
+                        std::this_thread::yield();
+                    }
+                }, priority, token });
             }
         }
+        m_meshStats.submitted += jobs.size();
+        m_meshStats.dropped = m_pool->dropped();
+        m_pool->submit_batch(jobs);
     }
     
-    gfx::MeshData WorldRenderer::build_mesh_data(const World& world, int cx, int cz) {
+    void WorldRenderer::upload_pending_meshes(const World& world, const glm::vec3& camPos, int viewDistance) {
+        int pCX = static_cast<int>(std::floor(camPos.x / static_cast<float>(CHUNK_SIZE_X)));
+        int pCZ = static_cast<int>(std::floor(camPos.z / static_cast<float>(CHUNK_SIZE_Z)));
+
+        m_uploadStats = UploadStats();
+        auto start = std::chrono::steady_clock::now();
+
+        // 転送しないものを先に除く
+        //   チャンクが消えた: 捨てる
+        //   構築後にチャンクが変更された / 視界外へ出た: 捨てて Dirty のまま依頼し直す
+        auto stale = [&](const gfx::MeshData& data) {
+            Chunk* chunk = world.get_chunk_ptr(data.cx, data.cz);
+            if (!chunk) return true;
+            bool outside = std::abs(data.cx - pCX) > viewDistance || std::abs(data.cz - pCZ) > viewDistance;
+            if (data.version < chunk->version || outside) {
+                chunk->is_dirty = true;
+                chunk->is_meshing = false;
+                return true;
+            }
+            return false;
+        };
+        auto last = std::remove_if(m_pendingUploads.begin(), m_pendingUploads.end(), stale);
+        m_meshStats.wasted += m_pendingUploads.end() - last;
+        m_pendingUploads.erase(last, m_pendingUploads.end());
+        if (m_pendingUploads.empty()) return;
+
+        // カメラに近い順 (水平距離)
+        auto distance2 = [&](const gfx::MeshData& data) {
+            float dx = (data.cx + 0.5f) * CHUNK_SIZE_X - camPos.x;
+            float dz = (data.cz + 0.5f) * CHUNK_SIZE_Z - camPos.z;
+            return dx * dx + dz * dz;
+        };
+        std::sort(m_pendingUploads.begin(), m_pendingUploads.end(),
+            [&](const gfx::MeshData& a, const gfx::MeshData& b) { return distance2(a) < distance2(b); });
+
+        size_t uploaded = 0;
+        for (const gfx::MeshData& data : m_pendingUploads) {
+            size_t bytes = (data.opaque_vertices.size() + data.trans_vertices.size()) * sizeof(gfx::PackedVertex);
+            if (m_uploadBudget != 0 && uploaded > 0 && m_uploadStats.bytes + bytes > m_uploadBudget) break;
+
+            Chunk* chunk = world.get_chunk_ptr(data.cx, data.cz);
+            m_cubeRenderer.update_chunk_mesh(*chunk, data);
+            std::copy_n(data.section_connectivity.begin(), SECTION_COUNT, chunk->section_connectivity.begin());
+            std::copy_n(data.solid_heights.begin(), chunk->solid_heights.size(), chunk->solid_heights.begin());
+            chunk->is_meshing = false;
+            uploaded++;
+
+            m_uploadStats.meshes++;
+            m_uploadStats.bytes += bytes;
+            m_meshStats.meshes++;
+            m_meshStats.faces += data.face_count;
+            m_meshStats.quads += (data.opaque_vertices.size() + data.trans_vertices.size()) / 4;
+        }
+        m_pendingUploads.erase(m_pendingUploads.begin(), m_pendingUploads.begin() + uploaded);
+        m_uploadStats.deferred = static_cast<uint32_t>(m_pendingUploads.size());
+        m_uploadStats.micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    gfx::MeshData WorldRenderer::build_mesh_data(const ChunkSnapshot& snapshot, MeshMode mode) {
+        gfx::MeshData result;
+        switch (mode) {
+            case MeshMode::GREEDY: result = build_mesh_greedy(snapshot); break;
+            case MeshMode::BINARY: result = build_mesh_binary(snapshot); break;
+            case MeshMode::PER_FACE:
+            default: result = build_mesh_per_face(snapshot); break;
+        }
+        // セクション単位で描画できるように並べ替える
+        sort_quads_by_section(result.opaque_vertices, result.opaque_sections);
+        sort_quads_by_section(result.trans_vertices, result.trans_sections);
+
+        // 隠れたセクションを描画時に探索で除くための、面どうしのつながり
+        result.section_connectivity.resize(SECTION_COUNT);
+        for (int sy = 0; sy < SECTION_COUNT; sy++) {
+            result.section_connectivity[sy] = compute_face_connectivity(snapshot, sy);
+        }
+        result.solid_heights.resize(SOLID_CELLS * SOLID_CELLS);
+        compute_solid_heights(snapshot, result.solid_heights.data());
+        return result;
+    }
+
+    gfx::MeshData WorldRenderer::build_mesh_per_face(const ChunkSnapshot& snapshot) {
         gfx::MeshData result;
-        result.cx = cx;
-        result.cz = cz;
-        uint32_t opaque_vertex_offset = 0;
-        uint32_t transparent_vertex_offset = 0;
+        result.cx = snapshot.cx;
+        result.cz = snapshot.cz;
+        result.version = snapshot.version;
 
-        // チャンクを取得
-        Chunk* chunk = world.get_chunk_ptr(cx, cz);
-        if (!chunk) return result;
+        const uint8_t* blocks = snapshot.blocks;
 
         for (int y = 0; y < CHUNK_SIZE_Y; y++) {
+            // 空気のみ・完全に埋まったセクションは丸ごと飛ばす
+            if (y % SECTION_SIZE == 0 && snapshot.section_hidden[y / SECTION_SIZE]) {
+                y += SECTION_SIZE - 1;
+                continue;
+            }
+
             for (int z = 0; z < CHUNK_SIZE_Z; z++) {
-                for (int x = 0; x < CHUNK_SIZE_X; x++) {
-                    BlockID block = static_cast<BlockID>(chunk->get_block(x, y, z));
+                int idx = ChunkSnapshot::index(0, y, z);
+                for (int x = 0; x < CHUNK_SIZE_X; x++, idx++) {
+                    BlockID block = static_cast<BlockID>(blocks[idx]);
                     if (block == BlockID::AIR) continue; // AIR
 
-                    int wx = cx * CHUNK_SIZE_X + x;
-                    int wy = y;
-                    int wz = cz * CHUNK_SIZE_Z + z;
+                    // 格納先の参照を切り替える
+                    bool translucent = block_info(block).pass == RenderPass::TRANSLUCENT;
+                    auto& target_vertices = translucent ? result.trans_vertices : result.opaque_vertices;
 
-                    bool is_water = (block == BlockID::WATER);
+                    auto shuold_add_face = [&](int stride, BlockID id) {
+                        return is_face_visible(id, static_cast<BlockID>(blocks[idx + stride]));
+                    };
 
-                    // 格納先の参照を切り替える
-                    auto& target_vertices = is_water ? result.trans_vertices : result.opaque_vertices;
-                    auto& target_indices = is_water ? result.trans_indices : result.opaque_indices;
-                    auto& target_offset = is_water ? transparent_vertex_offset : opaque_vertex_offset;
+                    if (shuold_add_face(ChunkSnapshot::STRIDE_Y, block)) {
+                        Chunk::add_face(target_vertices, x, y, z, FaceDirection::TOP, static_cast<uint8_t>(block));
+                    }
+                    if (y > 0 && shuold_add_face(-ChunkSnapshot::STRIDE_Y, block)) {
+                        Chunk::add_face(target_vertices, x, y, z, FaceDirection::BOTTOM, static_cast<uint8_t>(block));
+                    }
+                    if (shuold_add_face(ChunkSnapshot::STRIDE_Z, block)) {
+                        Chunk::add_face(target_vertices, x, y, z, FaceDirection::SIDE_FRONT, static_cast<uint8_t>(block));
+                    }
+                    if (shuold_add_face(-ChunkSnapshot::STRIDE_Z, block)) {
+                        Chunk::add_face(target_vertices, x, y, z, FaceDirection::SIDE_BACK, static_cast<uint8_t>(block));
+                    }
+                    if (shuold_add_face(ChunkSnapshot::STRIDE_X, block)) {
+                        Chunk::add_face(target_vertices, x, y, z, FaceDirection::SIDE_RIGHT, static_cast<uint8_t>(block));
+                    }
+                    if (shuold_add_face(-ChunkSnapshot::STRIDE_X, block)) {
+                        Chunk::add_face(target_vertices, x, y, z, FaceDirection::SIDE_LEFT, static_cast<uint8_t>(block));
+                    }
+                }
+            }
+        }
+        result.face_count = static_cast<uint32_t>((result.opaque_vertices.size() + result.trans_vertices.size()) / 4);
+        return result;
+    }
+
+    gfx::MeshData WorldRenderer::build_mesh_greedy(const ChunkSnapshot& snapshot) {
+        gfx::MeshData result;
+        result.cx = snapshot.cx;
+        result.cz = snapshot.cz;
+        result.version = snapshot.version;
 
-                    auto shuold_add_face = [&](int nx, int ny, int nz, BlockID id) {
-                        BlockID neighbor = world.get_block(nx, ny, nz);
+        const uint8_t* blocks = snapshot.blocks;
+        const int dims[3] = { CHUNK_SIZE_X, CHUNK_SIZE_Y, CHUNK_SIZE_Z };
+
+        // 面の向きごとの軸: n = 法線方向, u = 幅 (w) 方向, v = 高さ (h) 方向 (0:x, 1:y, 2:z)
+        // u/v の割り当ては Chunk::add_quad の w/h と一致させる
+        struct Axis {
+            FaceDirection dir;
+            int n, u, v;
+            int stride; // 隣接ブロックへの差分
+        };
+        static const Axis axes[6] = {
+            { FaceDirection::TOP,        1, 0, 2,  ChunkSnapshot::STRIDE_Y },
+            { FaceDirection::BOTTOM,     1, 0, 2, -ChunkSnapshot::STRIDE_Y },
+            { FaceDirection::SIDE_FRONT, 2, 0, 1,  ChunkSnapshot::STRIDE_Z },
+            { FaceDirection::SIDE_BACK,  2, 0, 1, -ChunkSnapshot::STRIDE_Z },
+            { FaceDirection::SIDE_RIGHT, 0, 2, 1,  ChunkSnapshot::STRIDE_X },
+            { FaceDirection::SIDE_LEFT,  0, 2, 1, -ChunkSnapshot::STRIDE_X },
+        };
+
+        // スライス内の各セルに、面を出すブロックのID (0 = 面なし) を入れる
+        std::vector<uint8_t> mask;
+
+        for (const Axis& axis : axes) {
+            const int U = dims[axis.u];
+            const int V = dims[axis.v];
+            mask.assign(U * V, 0);
+
+            for (int slice = 0; slice < dims[axis.n]; slice++) {
+                if (axis.n == 1) {
+                    // 面が出ないセクション・最下段の底面は飛ばす
+                    if (snapshot.section_hidden[slice / SECTION_SIZE]) continue;
+                    if (axis.dir == FaceDirection::BOTTOM && slice == 0) continue;
+                }
+
+                int pos[3];
+                pos[axis.n] = slice;
+                bool any = false;
+
+                for (int v = 0; v < V; v++) {
+                    pos[axis.v] = v;
+                    // 縦のスライスでも、面が出ないセクションの行は飛ばす
+                    if (axis.v == 1 && snapshot.section_hidden[v / SECTION_SIZE]) {
+                        std::fill_n(&mask[v * U], U, 0);
+                        continue;
+                    }
+                    for (int u = 0; u < U; u++) {
+                        pos[axis.u] = u;
+                        uint8_t& cell = mask[v * U + u];
+                        cell = 0;
+                        if (axis.dir == FaceDirection::BOTTOM && pos[1] == 0) continue;
 
-                        // 隣が空気なら描画
-                        if (neighbor == BlockID::AIR) return true; // AIR
+                        int idx = ChunkSnapshot::index(pos[0], pos[1], pos[2]);
+                        BlockID block = static_cast<BlockID>(blocks[idx]);
+                        if (block == BlockID::AIR) continue;
+                        if (!is_face_visible(block, static_cast<BlockID>(blocks[idx + axis.stride]))) continue;
+                        result.face_count++;
 
-                        // 自身がサボテン
-                        if (id == BlockID::CACTUS) {
-                            // 隣がサボテンなら描画しない
-                            if (neighbor == BlockID::CACTUS) return false;
-                            return true;
+                        // 内側に寄せるブロック (サボテン) は結合せずそのまま出す
+                        if (block_info(block).inset) {
+                            Chunk::add_face(result.opaque_vertices, pos[0], pos[1], pos[2],
+                                            axis.dir, static_cast<uint8_t>(block));
+                            continue;
                         }
+                        cell = static_cast<uint8_t>(block);
+                        any = true;
+                    }
+                }
+                if (!any) continue;
+
+                // 同じIDの矩形を貪欲に広げる: まず u 方向、次に v 方向
+                for (int v = 0; v < V; v++) {
+                    for (int u = 0; u < U; ) {
+                        uint8_t id = mask[v * U + u];
+                        if (id == 0) { u++; continue; }
 
-                        // 不透明ブロック
-                        if (world.is_opaque(wx, wy, wz)) {
-                            // 隣が空気・水・サボテン・葉なら描画
-                            if (neighbor == BlockID::WATER || neighbor == BlockID::CACTUS || neighbor == BlockID::LEAVES) {
-                                return true;
+                        int w = 1;
+                        while (u + w < U && mask[v * U + u + w] == id) w++;
+
+                        // 縦方向はセクションの境界をまたがない (セクション単位でカリングするため)
+                        int h = 1;
+                        for (; v + h < V; h++) {
+                            if (axis.v == 1 && (v + h) % SECTION_SIZE == 0) break;
+                            const uint8_t* row = &mask[(v + h) * U + u];
+                            bool same = true;
+                            for (int k = 0; k < w; k++) {
+                                if (row[k] != id) { same = false; break; }
                             }
-                            // 隣が不透明ブロックなら描画しない
-                            return world.is_opaque(nx, ny, nz) ? false : true;
+                            if (!same) break;
                         }
 
-                        // 自身が葉
-                        if (id == BlockID::LEAVES) {
-                            // 隣が空気や水なら描画
-                            return (neighbor == BlockID::AIR || neighbor == BlockID::WATER);
+                        for (int dv = 0; dv < h; dv++) {
+                            std::fill_n(&mask[(v + dv) * U + u], w, 0);
                         }
 
+                        pos[axis.u] = u;
+                        pos[axis.v] = v;
+                        bool translucent = block_info(id).pass == RenderPass::TRANSLUCENT;
+                        auto& target_vertices = translucent ? result.trans_vertices : result.opaque_vertices;
+                        Chunk::add_quad(target_vertices, pos[0], pos[1], pos[2],
+                                        axis.dir, w, h, id);
+                        u += w;
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    gfx::MeshData WorldRenderer::build_mesh_binary(const ChunkSnapshot& snapshot) {
+        gfx::MeshData result;
+        result.cx = snapshot.cx;
+        result.cz = snapshot.cz;
+        result.version = snapshot.version;
+
+        // is_face_visible の規則をブロックの分類 (BlockClass) ごとのビット演算に置き換える
+        constexpr int CLS_COUNT = static_cast<int>(BlockClass::COUNT);
+
+        constexpr int PAD_X = ChunkSnapshot::PAD_X;
+        constexpr int ROWS = ChunkSnapshot::PAD_Y * ChunkSnapshot::PAD_Z;
+        // x 方向の1行 (パディング込み18個) を1ワードのビットに詰める。bit i = パディング込みの x 座標 i
+        // 行のインデックスは ChunkSnapshot::index(0, y, z) / PAD_X
+        std::vector<uint32_t> masks(static_cast<size_t>(CLS_COUNT) * ROWS, 0);
+        uint32_t* cls_mask[CLS_COUNT];
+        for (int c = 0; c < CLS_COUNT; c++) cls_mask[c] = &masks[static_cast<size_t>(c) * ROWS];
 
-                        if (is_water) {
-                            return false;
-                        } else {
-                            return (neighbor == BlockID::WATER);
+        const uint8_t* blocks = snapshot.blocks;
+        for (int row = 0; row < ROWS; row++) {
+            const uint8_t* cells = &blocks[row * PAD_X];
+            for (int x = 0; x < PAD_X; x++) {
+                cls_mask[static_cast<int>(block_info(cells[x]).cls)][row] |= 1u << x;
+            }
+        }
+
+        // 隣接ブロックのマスクから可視面のマスクを求める
+        // 分類 c のブロックのうち、CLASS_FACES_AGAINST[c] に含まれる分類と接するもの
+        auto visible = [&](int row, int nrow, int shift) {
+            uint32_t n_cls[CLS_COUNT];
+            for_each_class([&](auto n) {
+                uint32_t m = cls_mask[n][nrow];
+                n_cls[n] = shift > 0 ? (m >> shift) : (m << -shift);
+            });
+            uint32_t vis = 0;
+            for_each_class([&](auto c) {
+                uint32_t against = 0;
+                for_each_class([&](auto n) {
+                    if constexpr ((CLASS_FACES_AGAINST[c] >> n) & 1) against |= n_cls[n];
+                });
+                vis |= cls_mask[c][row] & against;
+            });
+            // パディングを除いた x = 0..15 (bit 1..16) のみ
+            return vis & (((1u << CHUNK_SIZE_X) - 1) << 1);
+        };
+
+        constexpr int ROW_Y = ChunkSnapshot::STRIDE_Y / PAD_X;
+        constexpr int ROW_Z = ChunkSnapshot::STRIDE_Z / PAD_X;
+
+        for (int y = 0; y < CHUNK_SIZE_Y; y++) {
+            if (y % SECTION_SIZE == 0 && snapshot.section_hidden[y / SECTION_SIZE]) {
+                y += SECTION_SIZE - 1;
+                continue;
+            }
+
+            for (int z = 0; z < CHUNK_SIZE_Z; z++) {
+                const int row = ChunkSnapshot::index(0, y, z) / PAD_X;
+
+                // PER_FACE と同じ順 (上, 下, 前, 後, 右, 左) で出力する
+                const uint32_t faces[6] = {
+                    visible(row, row + ROW_Y, 0),
+                    y > 0 ? visible(row, row - ROW_Y, 0) : 0u,
+                    visible(row, row + ROW_Z, 0),
+                    visible(row, row - ROW_Z, 0),
+                    visible(row, row, 1),
+                    visible(row, row, -1),
+                };
+                static const FaceDirection dirs[6] = {
+                    FaceDirection::TOP, FaceDirection::BOTTOM,
+                    FaceDirection::SIDE_FRONT, FaceDirection::SIDE_BACK,
+                    FaceDirection::SIDE_RIGHT, FaceDirection::SIDE_LEFT,
+                };
+
+                uint32_t any = faces[0] | faces[1] | faces[2] | faces[3] | faces[4] | faces[5];
+                while (any) {
+                    int bit = __builtin_ctz(any);
+                    any &= any - 1;
+                    int x = bit - 1;
+
+                    uint8_t block = blocks[ChunkSnapshot::index(x, y, z)];
+                    bool translucent = block_info(block).pass == RenderPass::TRANSLUCENT;
+                    auto& target_vertices = translucent ? result.trans_vertices : result.opaque_vertices;
+
+                    for (int f = 0; f < 6; f++) {
+                        if (faces[f] & (1u << bit)) {
+                            Chunk::add_face(target_vertices, x, y, z, dirs[f], block);
                         }
-                        
-                        return world.is_opaque(nx, ny, nz);
-                    };
-    
-                    if (shuold_add_face(wx, wy + 1, wz, block)) {
-                        Chunk::add_face(target_vertices, target_indices, x, y, z, FaceDirection::TOP, target_offset, static_cast<uint8_t>(block));
-                    }
-                    if (wy > 0 && shuold_add_face(wx, wy - 1, wz, block)) {
-                        Chunk::add_face(target_vertices, target_indices, x, y, z, FaceDirection::BOTTOM, target_offset, static_cast<uint8_t>(block));
-                    }
-                    if (shuold_add_face(wx, wy, wz + 1, block)) {
-                        Chunk::add_face(target_vertices, target_indices, x, y, z, FaceDirection::SIDE_FRONT, target_offset, static_cast<uint8_t>(block));
-                    }
-                    if (shuold_add_face(wx, wy, wz - 1, block)) {
-                        Chunk::add_face(target_vertices, target_indices, x, y, z, FaceDirection::SIDE_BACK, target_offset, static_cast<uint8_t>(block));
-                    }
-                    if (shuold_add_face(wx + 1, wy, wz, block)) {
-                        Chunk::add_face(target_vertices, target_indices, x, y, z, FaceDirection::SIDE_RIGHT, target_offset, static_cast<uint8_t>(block));
-                    }
-                    if (shuold_add_face(wx - 1, wy, wz, block)) {
-                        Chunk::add_face(target_vertices, target_indices, x, y, z, FaceDirection::SIDE_LEFT, target_offset, static_cast<uint8_t>(block));
                     }
                 }
             }
         }
+        result.face_count = static_cast<uint32_t>((result.opaque_vertices.size() + result.trans_vertices.size()) / 4);
         return result;
     }
 } // namespace ocm
\ No newline at end of file
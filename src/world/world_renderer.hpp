@@ -3,14 +3,55 @@
 #include <vector>
 #include <cstdint>
 #include <future>
-#include <queue>
-#include <mutex>
+#include <unordered_map>
 #include "chunk.hpp"
 #include "world.hpp"
+#include "chunk_snapshot.hpp"
+#include "section_visibility.hpp"
 #include "../gfx/cube_renderer.hpp"
+#include "../gfx/frustum.hpp"
+#include "../gfx/occlusion_buffer.hpp"
 #include "../util/thread_pool.hpp"
+#include "../util/mpsc_queue.hpp"
 
 namespace ocm {
+    // メッシュ生成方式
+    enum class MeshMode {
+        PER_FACE, // 露出した面ごとに1枚
+        GREEDY,   // 同一平面・同じ向き・同じブロックの面を矩形に結合
+        BINARY,   // 行ごとのビットマスクで可視面をまとめて判定 (出力は PER_FACE と同一)
+    };
+
+    // メッシュ生成の統計
+    struct MeshStats {
+        uint64_t meshes = 0; // 転送したメッシュ数
+        uint64_t faces = 0;  // 結合前の可視面の数
+        uint64_t quads = 0;  // 実際に出力した四角形の数 (頂点数 / 4)
+
+        uint64_t submitted = 0; // 依頼したメッシュ構築の数
+        uint64_t wasted = 0;    // 構築したが捨てた数 (チャンクが更新済み・取り消し済み)
+        uint64_t dropped = 0;   // 実行前に取り消した数
+    };
+
+    // 直近フレームの GPU 転送の統計
+    struct UploadStats {
+        uint32_t meshes = 0;   // 転送したメッシュ数
+        size_t bytes = 0;      // 転送した頂点データのバイト数
+        double micros = 0.0;   // 転送にかかった CPU 時間 (glBufferData の呼び出しを含む)
+        uint32_t deferred = 0; // 予算超過で次のフレームへ回したメッシュ数
+    };
+
+    // 直近フレームのカリングの統計 (メッシュを持つチャンク・セクションが対象)
+    struct CullStats {
+        uint32_t chunks = 0;            // 判定したチャンク数
+        uint32_t chunks_culled = 0;     // 全セクションを描画しなかったチャンク数
+        uint32_t sections = 0;          // 判定したセクション数
+        uint32_t sections_culled = 0;   // 描画しなかったセクション数 (視錐台の外 + 辿れない)
+        uint32_t sections_occluded = 0; // 視錐台の内にあるが、カメラから辿れなかったセクション数
+        uint32_t sections_hidden = 0;   // 辿れたが、CPU の深度バッファで遮蔽物の奥にあったセクション数
+        uint32_t occluders = 0;         // 深度バッファへ描いた遮蔽物の箱の数
+    };
+
     class WorldRenderer {
         public:
             WorldRenderer();
@@ -20,9 +61,35 @@ namespace ocm {
 
             // Dirtyなチャンクのメッシュ構築と描画を行う
             void render(const World& world, const glm::vec3& camPos, const glm::mat4& viewProj, int viewDistance);
-            // 特定のチャンクのメッシュを構築・更新
-            void update_meshes(const World& world);
+            // 視界内の Dirty なチャンクのメッシュ構築を依頼し、完成したものを転送する
+            // カメラの前方のチャンクを優先し、視界外へ出た未着手の依頼は取り消す
+            void update_meshes(const World& world, const glm::vec3& camPos, const glm::mat4& viewProj, int viewDistance);
             // void update_single_chunk_mesh(const World& world, Chunk& chunk);
+            // アンロードされるチャンクの GPU 上の区間を返却する (World::set_unload_callback に渡す)
+            void release_chunk(Chunk& chunk);
+
+            void set_mesh_mode(MeshMode mode) { m_meshMode = mode; }
+            MeshMode mesh_mode() const noexcept { return m_meshMode; }
+            const MeshStats& mesh_stats() const noexcept { return m_meshStats; }
+
+            // 1フレームに転送する頂点データの上限 (0 で無制限)
+            // 超えた分はカメラに近い順に次のフレームへ持ち越す (1フレームに最低1つは転送する)
+            void set_upload_budget(size_t bytes) { m_uploadBudget = bytes; }
+            size_t upload_budget() const noexcept { return m_uploadBudget; }
+            const UploadStats& upload_stats() const noexcept { return m_uploadStats; }
+            const CullStats& cull_stats() const noexcept { return m_cullStats; }
+            // カメラのセクションから、不透明でないブロックを通って辿れるセクションだけを描画する
+            void set_occlusion_culling(bool enabled) { m_occlusionCulling = enabled; }
+            bool occlusion_culling() const noexcept { return m_occlusionCulling; }
+            // 下から詰まった地形の箱を CPU で低解像度の深度バッファへ描き、その奥のセクションを描画しない
+            void set_depth_occlusion(bool enabled) { m_depthOcclusion = enabled; }
+            bool depth_occlusion() const noexcept { return m_depthOcclusion; }
+            // 共有頂点バッファの使用状況
+            const gfx::BufferArena& mesh_arena() const noexcept { return m_cubeRenderer.arena(); }
+
+            // 頂点データを組み立てる (描画コンテキスト不要)
+            // snapshot は隣接チャンクの境界を含むコピーなので、ワーカースレッドから安全に呼べる
+            static gfx::MeshData build_mesh_data(const ChunkSnapshot& snapshot, MeshMode mode);
 
         private:
             gfx::CubeRenderer m_cubeRenderer;
@@ -30,10 +97,58 @@ namespace ocm {
             // 実行中の非同期タスクを保持
             std::unique_ptr<util::ThreadPool> m_pool;
 
-            std::queue<gfx::MeshData> m_meshResults; // 計算済みデータの待ち行列
-            std::mutex m_resultMutex;                // キュー操作の排他制御
+            struct MeshResult {
+                gfx::MeshData data;
+                util::CancelToken token; // 依頼時のトークン (取り消し・再依頼された結果は捨てる)
+            };
+            // ワーカーから描画スレッドへの計算済みデータ (ロックなし)
+            // 依頼中の数をこの容量までに抑えるので、通常は満杯にならない
+            static constexpr size_t MESH_RESULT_CAPACITY = 256;
+            util::MPSCQueue<MeshResult> m_meshResults{MESH_RESULT_CAPACITY};
+            struct MeshJob {
+                util::CancelToken token;
+                uint32_t version; // 依頼時の Chunk::version
+            };
+            std::unordered_map<uint64_t, MeshJob> m_meshJobs; // 依頼中のチャンク (ChunkMap::pack_key)
+
+            std::vector<gfx::MeshData> m_pendingUploads; // 完成済みで転送待ちのメッシュ
+            size_t m_uploadBudget = size_t(256) << 10;
+            UploadStats m_uploadStats;
+
+            CullStats m_cullStats;
+
+            // カメラから辿れるセクション (視界の正方形の格子、チャンクごとに bit s)
+            bool m_occlusionCulling = true;
+            std::vector<uint8_t> m_reachable;
+            struct ReachOrigin {
+                int cx = 0, cz = 0, radius = 0;
+                bool valid = false; // false なら全て辿れるものとする
+            } m_reachOrigin;
+
+            // CPU の遮蔽判定 (画面とほぼ同じ縦横比の低解像度)
+            static constexpr int OCCLUSION_WIDTH = 256;
+            static constexpr int OCCLUSION_HEIGHT = 144;
+            bool m_depthOcclusion = true;
+            gfx::OcclusionBuffer m_occlusionBuffer{OCCLUSION_WIDTH, OCCLUSION_HEIGHT};
+            std::vector<gfx::AABB> m_occluders; // 今フレームの遮蔽物の箱
+            glm::mat4 m_viewProj{1.0f};
+
+            MeshMode m_meshMode = MeshMode::GREEDY;
+            MeshStats m_meshStats;
+
+            // 転送待ちのメッシュを予算の範囲でカメラに近い順に転送する
+            void upload_pending_meshes(const World& world, const glm::vec3& camPos, int viewDistance);
+
+            // カメラのセクションから面のつながりを幅優先で辿り、m_reachable を作る
+            void trace_reachable_sections(const World& world, const glm::vec3& camPos, int viewDistance);
+            // 視錐台の外のチャンクを chunks から除き、残ったチャンクの描画するセクションを sections に返す
+            void cull_chunks(const gfx::Frustum& frustum, std::vector<Chunk*>& chunks, std::vector<uint8_t>& sections);
+            // 遮蔽物を深度バッファへ描き、その奥に隠れたセクションを sections から除く
+            void cull_hidden_sections(std::vector<Chunk*>& chunks, std::vector<uint8_t>& sections);
 
-            // 実際に頂点データを組み立てる
-            gfx::MeshData build_mesh_data(const World& world, int cx, int cz);
+            // 実際に頂点データを組み立てる (方式ごとの本体)
+            static gfx::MeshData build_mesh_per_face(const ChunkSnapshot& snapshot);
+            static gfx::MeshData build_mesh_greedy(const ChunkSnapshot& snapshot);
+            static gfx::MeshData build_mesh_binary(const ChunkSnapshot& snapshot);
     };
 } // namespace ocm
\ No newline at end of file